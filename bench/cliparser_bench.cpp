@@ -0,0 +1,313 @@
+/**
+ * @file cliparser_bench.cpp
+ * @brief benchmark suite of cliparser::CliParser: construction, parse, positional arguments, snapshots, command streams, option lookup, getOption, help and the error paths, with the number of heap allocations per operation
+ * @version 1.0
+ * @date 2021-07-17
+ *
+ * Usage: ./cliparser_bench [scale]
+ *
+ * Every benchmark runs a number of iterations proportional to scale (default: 1) and prints the average time and the average number of allocations per operation.
+ * The allocations are counted by replacing the global operator new: compare them before and after a change to catch regressions.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <memory_resource>
+#include <span>
+#include <unordered_map>
+#include <libcliparser/cliparser.h>
+#include <libcliparser/exceptions.h>
+#include <libcliparser/command_stream.h>
+
+namespace {
+    std::size_t allocations = 0;  ///< the number of calls to the global operator new (the benchmark is single-threaded)
+}
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size != 0 ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {return operator new(size);}
+void operator delete(void* p) noexcept {std::free(p);}
+void operator delete[](void* p) noexcept {std::free(p);}
+void operator delete(void* p, std::size_t) noexcept {std::free(p);}
+void operator delete[](void* p, std::size_t) noexcept {std::free(p);}
+
+namespace {
+    volatile std::size_t sink = 0;  ///< keeps the results of the benchmarks alive
+
+    /**
+     * @brief run f iterations times and print the average nanoseconds and allocations per call
+     */
+    template <typename F>
+    void run(std::string_view name, std::size_t iterations, F&& f) {
+        if (iterations == 0) iterations = 1;
+        f();  // warm up (e.g. the help cache)
+        std::size_t allocationsBefore = allocations;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) f();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        double allocationsPerOp = static_cast<double>(allocations - allocationsBefore) / static_cast<double>(iterations);
+
+        std::cout << std::left << std::setw(44) << name << std::right << std::setw(14) << std::fixed << std::setprecision(1) << elapsed.count() / static_cast<double>(iterations) << " ns"
+            << std::setw(12) << std::setprecision(2) << allocationsPerOp << " allocs\n";
+    }
+
+    std::string optionName(std::size_t i) {return "--opt" + std::to_string(i);}
+
+    /**
+     * @brief add n int options (the even ones are required) to parser
+     */
+    void addOptions(cliparser::CliParser& parser, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (i % 2 == 0) parser.option<int>(optionName(i), "a required int option");
+            else parser.option(optionName(i), "an optional int option, with a description of average length", 0);
+        }
+    }
+
+    /**
+     * @brief a command line that sets all the n options of addOptions. The strings are owned by the CommandLine
+     */
+    struct CommandLine {
+        std::vector<std::string> tokens;
+        std::vector<char*> argv;
+
+        explicit CommandLine(std::size_t n) {
+            tokens.push_back("bench");
+            for (std::size_t i = 0; i < n; ++i) tokens.push_back(optionName(i) + "=" + std::to_string(i));
+            for (std::string& t : tokens) argv.push_back(t.data());
+        }
+
+        int argc() const {return static_cast<int>(argv.size());}
+    };
+
+    void benchConstruction(std::size_t scale) {
+        for (std::size_t n : {10, 100, 10000}) {
+            run("construct+destroy, " + std::to_string(n) + " options", 100000 * scale / n, [n]() {
+                cliparser::CliParser parser("bench", "benchmark");
+                addOptions(parser, n);
+                sink = sink + parser.getAllPossibleOptions().size();
+            });
+        }
+    }
+
+    void benchParse(std::size_t scale) {
+        for (std::size_t n : {10, 100, 10000}) {
+            cliparser::CliParser parser("bench", "benchmark");
+            addOptions(parser, n);
+            CommandLine line(n);
+            run("parse, " + std::to_string(n) + " options", 1000000 * scale / n, [&]() {
+                parser.reset();
+                parser.parse(line.argc(), line.argv.data());
+            });
+
+            cliparser::ParseResult result(parser);
+            run("tryParse into a ParseResult, " + std::to_string(n) + " options", 1000000 * scale / n, [&]() {
+                result.reset();
+                sink = sink + static_cast<std::size_t>(parser.tryParse(line.argc(), line.argv.data(), result).code);
+            });
+        }
+    }
+
+    void benchParsePmr(std::size_t scale) {
+        for (std::size_t n : {10, 100, 10000}) {
+            std::vector<std::byte> buffer(n * 1024);  // the schema, the result and the help cache all fit in the buffer
+            std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+            cliparser::CliParser parser("bench", "benchmark", "1.0", &arena);
+            addOptions(parser, n);
+            CommandLine line(n);
+            cliparser::ParseResult result(parser);
+            run("tryParse, monotonic buffer, " + std::to_string(n) + " options", 1000000 * scale / n, [&]() {
+                result.reset();
+                sink = sink + static_cast<std::size_t>(parser.tryParse(line.argc(), line.argv.data(), result).code);
+            });
+        }
+    }
+
+    /**
+     * @brief a glob expansion: a few options and many positional arguments (the views are collected, not copied)
+     */
+    void benchPositionals(std::size_t scale) {
+        for (std::size_t n : {1000, 500000}) {
+            cliparser::CliParser parser("bench", "benchmark");
+            addOptions(parser, 10);
+            parser.enablePositionals();
+            CommandLine line(10);
+            for (std::size_t i = 0; i < n; ++i) line.tokens.push_back("src/module" + std::to_string(i) + "/file.cpp");
+            line.argv.clear();
+            for (std::string& t : line.tokens) line.argv.push_back(t.data());
+            cliparser::ParseResult result(parser);
+            run("tryParse, 10 options and " + std::to_string(n) + " positionals", 10000000 * scale / n, [&]() {
+                sink = sink + static_cast<std::size_t>(parser.tryParse(line.argc(), line.argv.data(), result).code) + result.positionals().size();
+            });
+        }
+    }
+
+    /**
+     * @brief restoring a snapshot of a parse instead of parsing the command line again (what a worker started by the program does)
+     */
+    void benchSnapshot(std::size_t scale) {
+        for (std::size_t n : {10, 100, 10000}) {
+            cliparser::CliParser parser("bench", "benchmark");
+            addOptions(parser, n);
+            CommandLine line(n);
+            cliparser::ParseResult result(parser);
+            parser.parse(line.argc(), line.argv.data(), result);
+            std::vector<std::byte> snapshot(result.snapshot());
+            run("snapshot, " + std::to_string(n) + " options", 1000000 * scale / n, [&]() {sink = sink + result.snapshot(snapshot);});
+            run("restore, " + std::to_string(n) + " options", 1000000 * scale / n, [&]() {sink = sink + static_cast<std::size_t>(result.restore(snapshot).code);});
+        }
+    }
+
+    void benchCommandStream(std::size_t scale) {
+        constexpr std::size_t n = 10, commands = 10000;
+        cliparser::CliParser parser("bench", "benchmark");
+        addOptions(parser, n);
+        CommandLine line(n);
+        std::FILE* file = std::tmpfile();
+        if (file == nullptr) return;
+        for (std::size_t c = 0; c < commands; ++c) {
+            for (std::size_t t = 1; t < line.tokens.size(); ++t) std::fwrite(line.tokens[t].c_str(), 1, line.tokens[t].size() + 1, file);  // with the NUL byte
+            std::fputc('\0', file);
+        }
+        std::fflush(file);
+
+        cliparser::ParseResult result(parser);
+        run("CommandStream, 10000 commands of 10 options", 10 * scale, [&]() {
+            std::rewind(file);
+            cliparser::CommandStream stream(fileno(file), "bench");
+            while (stream.next()) sink = sink + static_cast<std::size_t>(stream.tryParse(parser, result).code);
+        });
+        std::fclose(file);
+    }
+
+    /**
+     * @brief the lookup of n option names (and of an unknown one) with the small index and with hashing, to find where hashing becomes faster. 
+     * The parser switches to hashing above _detail::SmallIndex::capacity options
+     */
+    void benchLookup(std::size_t scale) {
+        for (std::size_t n : {2, 4, 8, 12, 16}) {
+            std::vector<std::string> keys;
+            for (std::size_t i = 0; i < n; ++i) keys.push_back(optionName(i * 37));  // names of different lengths
+            keys.push_back("--unknown");
+            std::vector<std::string_view> names(keys.begin(), keys.end() - 1);
+            cliparser::_detail::SmallIndex index;
+            std::unordered_map<std::string_view, std::size_t> hashed;
+            for (std::size_t i = 0; i < n; ++i) {
+                index.push_back(names[i]);
+                hashed.emplace(names[i], i);
+            }
+
+            const std::size_t iterations = 1000000 * scale;
+            run("lookup, small index, " + std::to_string(n) + " options", iterations, [&, k = std::size_t(0)]() mutable {
+                sink = sink + index.find(keys[k], names.data());
+                if (++k == keys.size()) k = 0;
+            });
+            run("lookup, hashing, " + std::to_string(n) + " options", iterations, [&, k = std::size_t(0)]() mutable {
+                std::unordered_map<std::string_view, std::size_t>::const_iterator it = hashed.find(keys[k]);
+                sink = sink + (it != hashed.end() ? it->second : 0);
+                if (++k == keys.size()) k = 0;
+            });
+        }
+
+        for (std::size_t n : {cliparser::_detail::SmallIndex::capacity, cliparser::_detail::SmallIndex::capacity + 1}) {
+            cliparser::CliParser parser("bench", "benchmark");
+            addOptions(parser, n);
+            std::vector<std::string> keys;
+            for (std::size_t i = 0; i < n; ++i) keys.push_back(optionName(i));
+            run("hasOption, " + std::to_string(n) + " options", 1000000 * scale, [&, k = std::size_t(0)]() mutable {
+                sink = sink + parser.hasOption(keys[k]);
+                if (++k == keys.size()) k = 0;
+            });
+        }
+    }
+
+    template <typename Argument>
+    void benchGetOption(std::string_view type, cliparser::CliParser& parser, const std::string& opt, std::size_t iterations) {
+        run("getOption<" + std::string(type) + ">", iterations, [&]() {
+            if constexpr (std::same_as<Argument, std::string> || std::same_as<Argument, std::string_view>) sink = sink + parser.getOption<Argument>(opt).size();
+            else sink = sink + static_cast<std::size_t>(parser.getOption<Argument>(opt));
+        });
+        cliparser::OptionHandle<Argument> handle = parser.handle<Argument>(opt);
+        run("getOption<" + std::string(type) + "> (handle)", iterations, [&]() {
+            if constexpr (std::same_as<Argument, std::string> || std::same_as<Argument, std::string_view>) sink = sink + parser.getOption(handle).size();
+            else sink = sink + static_cast<std::size_t>(parser.getOption(handle));
+        });
+    }
+
+    void benchGetOptions(std::size_t scale) {
+        cliparser::CliParser parser("bench", "benchmark");
+        addOptions(parser, 100);  // the lookups are done in a realistic dictionary
+        parser.option("-i", "int", 1).option("-l", "long", 2L).option("-ll", "long long", 3LL).option("-b", "bool", true)
+            .option("-f", "float", 4.0f).option("-d", "double", 5.0).option("-ld", "long double", 6.0L)
+            .option("-s", "string", std::string("a string longer than the small string optimisation"))
+            .option("-sv", "string_view", std::string_view("a view"));
+        const std::size_t iterations = 10000000 * scale;
+        benchGetOption<int>("int", parser, "-i", iterations);
+        benchGetOption<long>("long", parser, "-l", iterations);
+        benchGetOption<long long>("long long", parser, "-ll", iterations);
+        benchGetOption<bool>("bool", parser, "-b", iterations);
+        benchGetOption<float>("float", parser, "-f", iterations);
+        benchGetOption<double>("double", parser, "-d", iterations);
+        benchGetOption<long double>("long double", parser, "-ld", iterations);
+        benchGetOption<std::string>("std::string", parser, "-s", iterations);
+        benchGetOption<std::string_view>("std::string_view", parser, "-sv", iterations);
+    }
+
+    void benchHelp(std::size_t scale) {
+        cliparser::CliParser parser("bench", "benchmark");
+        addOptions(parser, 100);
+        run("help(true), 100 options", 10000 * scale, [&]() {sink = sink + parser.help(true).size();});
+        std::vector<char> buffer(parser.help(std::span<char>(), true));
+        run("help(buffer, true), 100 options", 10000 * scale, [&]() {sink = sink + parser.help(buffer, true);});
+    }
+
+    void benchErrors(std::size_t scale) {
+        cliparser::CliParser parser("bench", "benchmark");
+        addOptions(parser, 100);
+        char* unknown[] = {const_cast<char*>("bench"), const_cast<char*>("--no-such-option")};
+        char* invalid[] = {const_cast<char*>("bench"), const_cast<char*>("--opt0=abc")};
+        char* missing[] = {const_cast<char*>("bench")};
+        const std::size_t iterations = 100000 * scale;
+
+        run("tryParse, unknown option", iterations, [&]() {sink = sink + static_cast<std::size_t>(parser.tryParse(2, unknown).code);});
+        run("tryParse, invalid value", iterations, [&]() {sink = sink + static_cast<std::size_t>(parser.tryParse(2, invalid).code);});
+        run("tryParse, missing required options", iterations, [&]() {sink = sink + static_cast<std::size_t>(parser.tryParse(1, missing).code);});
+        run("parse, unknown option (exception)", iterations, [&]() {
+            try {parser.parse(2, unknown);}
+            catch (const cliparser::NoSuchOptionException& e) {sink = sink + 1;}
+        });
+        run("parse, missing required options (exception)", iterations, [&]() {
+            try {parser.parse(1, missing);}
+            catch (const cliparser::MissingRequiredOptionsError& e) {sink = sink + 1;}
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t scale = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1;
+    if (scale == 0) scale = 1;
+
+    std::cout << std::left << std::setw(44) << "benchmark" << std::right << std::setw(17) << "time/op" << std::setw(19) << "allocations/op\n";
+    benchConstruction(scale);
+    benchParse(scale);
+    benchParsePmr(scale);
+    benchPositionals(scale);
+    benchSnapshot(scale);
+    benchCommandStream(scale);
+    benchLookup(scale);
+    benchGetOptions(scale);
+    benchHelp(scale);
+    benchErrors(scale);
+}
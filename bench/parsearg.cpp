@@ -0,0 +1,70 @@
+/**
+ * @file parsearg.cpp
+ * @brief benchmark of cliparser::CliParser::parseArg (std::from_chars) against the previous std::stoi/std::stod based implementation
+ * @version 1.0
+ * @date 2021-07-17
+ * 
+ * Usage: ./parsearg_bench [iterations]
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <cstdlib>
+#include <libcliparser/cliparser.h>
+
+namespace legacy {
+    // the parseArg specialisations used before std::from_chars
+    template <typename T> T parseArg(const char* input);
+    template <> int parseArg<int>(const char* input) {return std::stoi(input);}
+    template <> long long parseArg<long long>(const char* input) {return std::stoll(input);}
+    template <> double parseArg<double>(const char* input) {return std::stod(input);}
+    template <> bool parseArg<bool>(const char* input) {
+        std::string in(input);
+        for (std::string::iterator it = in.begin(); it != in.end(); ++it) {
+            *it += (*it >= 'A' && *it <='Z')*32;
+        }
+        if (in == "y" || in == "true") return true;
+        else if (in == "n" || in == "false") return false;
+        else throw std::invalid_argument("invalid bool argument");
+    }
+}
+
+/**
+ * @brief time f over all the inputs, iterations times, and return the average number of nanoseconds per conversion
+ */
+template <typename F>
+double nsPerOp(const char* const* inputs, std::size_t n, std::size_t iterations, F&& f) {
+    volatile double sink = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (std::size_t it = 0; it < iterations; ++it) {
+        for (std::size_t i = 0; i < n; ++i) sink = sink + static_cast<double>(f(inputs[i]));
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(iterations * n);
+}
+
+template <typename T>
+void compare(const char* name, const char* const* inputs, std::size_t n, std::size_t iterations) {
+    double before = nsPerOp(inputs, n, iterations, [](const char* in) {return legacy::parseArg<T>(in);});
+    double after = nsPerOp(inputs, n, iterations, [](const char* in) {return cliparser::CliParser::parseArg<T>(in);});
+    std::cout << name << "\t" << before << " ns\t" << after << " ns\t" << before / after << "x\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    const char* ints[] = {"0", "42", "-17", "123456", "2147483647", "-99999"};
+    const char* longs[] = {"0", "9223372036854775807", "-123456789012", "42"};
+    const char* doubles[] = {"3.1415", "-2.5e10", "0.000001", "42", "1e-300"};
+    const char* bools[] = {"true", "FALSE", "y", "N"};
+
+    std::cout << "type\t\tstd::sto*\tfrom_chars\tspeedup\n";
+    compare<int>("int\t", ints, std::size(ints), iterations);
+    compare<long long>("long long", longs, std::size(longs), iterations);
+    compare<double>("double\t", doubles, std::size(doubles), iterations);
+    compare<bool>("bool\t", bools, std::size(bools), iterations);
+}
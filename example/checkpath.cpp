@@ -23,6 +23,7 @@ int main (int argc, char* argv[]) {
     parser
         .option<std::string>("-p", "path")
         .option("-n", "times. Default value: 1", 1)
+        .constrain("-n", cliparser::AtLeast<1>{})  // checked by parse, right after the conversion of the value
         .flag("--ignore-n", "ignore the -n flag and print the result 3 times.");
     
     // parse the input
@@ -43,12 +44,6 @@ int main (int argc, char* argv[]) {
         n = 3;
     }
 
-    // additional step: add eventual constraits to your options
-    if (n < 1) {
-        std::cerr << "n must be strictly positive!\n";
-        std::exit(-1);
-    }
-    
     // the program
     std::string result;
     if (std::filesystem::exists(std::filesystem::path(p))) result = p + " exists.\n";
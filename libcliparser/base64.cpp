@@ -0,0 +1,68 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <libcliparser/base64.h>
+
+namespace cliparser {
+
+    namespace {
+        constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        constexpr unsigned char invalid = 0xff;  ///< the value of the characters that are not in the alphabet
+
+        constexpr std::array<unsigned char, 256> decodingTable = []() {
+            std::array<unsigned char, 256> table{};
+            table.fill(invalid);
+            for (std::size_t k = 0; k < alphabet.size(); ++k) table[static_cast<unsigned char>(alphabet[k])] = static_cast<unsigned char>(k);
+            return table;
+        }();
+    }
+
+    std::string toBase64(std::span<const std::byte> bytes) {
+        std::string text;
+        text.reserve((bytes.size() + 2) / 3 * 4);
+        std::size_t k = 0;
+        for (; k + 3 <= bytes.size(); k += 3) {
+            const std::uint32_t group = std::to_integer<std::uint32_t>(bytes[k]) << 16 | std::to_integer<std::uint32_t>(bytes[k + 1]) << 8 | std::to_integer<std::uint32_t>(bytes[k + 2]);
+            text += alphabet[group >> 18];
+            text += alphabet[(group >> 12) & 63];
+            text += alphabet[(group >> 6) & 63];
+            text += alphabet[group & 63];
+        }
+        if (const std::size_t rest = bytes.size() - k; rest != 0) {
+            const std::uint32_t group = std::to_integer<std::uint32_t>(bytes[k]) << 16 | (rest == 2 ? std::to_integer<std::uint32_t>(bytes[k + 1]) << 8 : 0);
+            text += alphabet[group >> 18];
+            text += alphabet[(group >> 12) & 63];
+            text += rest == 2 ? alphabet[(group >> 6) & 63] : '=';
+            text += '=';
+        }
+        return text;
+    }
+
+    bool fromBase64(std::string_view text, std::vector<std::byte>& bytes) {
+        bytes.clear();
+        if (text.size() % 4 != 0) return false;
+        bytes.reserve(text.size() / 4 * 3);
+        for (std::size_t k = 0; k < text.size(); k += 4) {
+            // only the last group may be padded, with one or two '='
+            const bool last = k + 4 == text.size();
+            const std::size_t padding = last ? (text[k + 3] == '=') + (text[k + 3] == '=' && text[k + 2] == '=') : 0;
+            std::uint32_t group = 0;
+            for (std::size_t j = 0; j < 4 - padding; ++j) {
+                const unsigned char value = decodingTable[static_cast<unsigned char>(text[k + j])];
+                if (value == invalid) return false;
+                group = group << 6 | value;
+            }
+            group <<= 6 * padding;
+            bytes.push_back(static_cast<std::byte>(group >> 16));
+            if (padding < 2) bytes.push_back(static_cast<std::byte>((group >> 8) & 0xff));
+            if (padding < 1) bytes.push_back(static_cast<std::byte>(group & 0xff));
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,49 @@
+/**
+ * @file base64.h
+ * @brief base64 encoding of binary data, e.g. of the snapshots of cliparser::ParseResult (see cliparser::ParseResult::snapshot), to pass them through an environment variable.
+ * @version 1.0
+ * @date 2021-07-17
+ *
+ * The alphabet is the standard one (RFC 4648, '+' and '/'), with '=' padding.
+ *
+ * example:
+ *
+ * setenv("APP_SNAPSHOT", cliparser::toBase64(parser.snapshot()).c_str(), 1);  // in the launcher
+ *
+ * std::vector<std::byte> bytes;  // in the worker. The std::string_view values of the options refer to bytes
+ * if (const char* text = std::getenv("APP_SNAPSHOT"); text != nullptr && cliparser::fromBase64(text, bytes) && !parser.restore(bytes)) run(parser);
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef LIBCLIPARSER_BASE64_H
+#define LIBCLIPARSER_BASE64_H
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cliparser {
+
+    /**
+     * @brief encode bytes in base64
+     *
+     * @param bytes the data
+     * @return std::string the text, 4 characters for every 3 bytes (the last group is padded)
+     */
+    [[nodiscard]] std::string toBase64(std::span<const std::byte> bytes);
+
+    /**
+     * @brief decode a base64 text written by toBase64
+     *
+     * @param text the text
+     * @param bytes the output. Its previous content is replaced (its capacity is reused)
+     * @return true if text is valid base64
+     * @return false otherwise. The content of bytes is unspecified
+     */
+    bool fromBase64(std::string_view text, std::vector<std::byte>& bytes);
+
+}
+
+#endif  // LIBCLIPARSER_BASE64_H
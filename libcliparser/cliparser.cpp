@@ -2,152 +2,1204 @@
 #include <vector>
 #include <string_view>
 #include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <span>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include <ostream>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <functional>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>  // _detail::SmallIndex::find
+#endif
+
+#ifdef _WIN32
+#include <stdlib.h>  // _environ
+#define LIBCLIPARSER_ENVIRON _environ
+#else
+extern char** environ;  // POSIX: the environment of the process
+#define LIBCLIPARSER_ENVIRON environ
+#endif
 
 #include <libcliparser/cliparser.h>
 #include <libcliparser/exceptions.h>
+#include <libcliparser/mapped_file.h>
 
 namespace cliparser {
 
-    void CliParser::_preliminaryCheckOptionForProblems(const std::string& opt) const {
-        if(hasOption(opt)) throw OptionRedefinitionError(opt);
+    namespace {
+        constexpr std::size_t maxResponseFileDepth = 32;  ///< a response file that includes itself stops here
+
+        /**
+         * @brief get the error code of a failed conversion (see CliParser::_convertArg and CliParser::_convertConstrained)
+         * 
+         * @param ec the result of the conversion, not std::errc()
+         * @return ParseErrc VALUE_OUT_OF_RANGE, CONSTRAINT_VIOLATION or INVALID_VALUE
+         */
+        ParseErrc conversionError(std::errc ec) noexcept {
+            if (ec == std::errc::result_out_of_range) return ParseErrc::VALUE_OUT_OF_RANGE;
+            return ec == std::errc::argument_out_of_domain ? ParseErrc::CONSTRAINT_VIOLATION : ParseErrc::INVALID_VALUE;
+        }
+
+        /**
+         * @brief TokenCursor class. It yields the tokens of argv one at a time and, if enabled, replaces each @file token with the tokens of the file (recursively). 
+         * The files are tokenized lazily: a file is never split into a vector of tokens
+         * 
+         */
+        class TokenCursor {
+            public:
+            /**
+             * @brief Construct a new TokenCursor object. The first token is argv[1]
+             * 
+             * @param argc argument counter
+             * @param argv argument value
+             * @param files where the mappings of the response files are stored, or nullptr to disable the expansion
+             * @param resource the memory resource of the stack of the response files being read
+             */
+            TokenCursor(int argc, char* argv[], std::pmr::vector<MappedFile>* files, std::pmr::memory_resource* resource) : argc(argc), argv(argv), stack(resource), files(files) {}
+
+            /**
+             * @brief get the next token
+             * 
+             * @param token the token
+             * @param index the index in argv of the token or, if the token comes from a response file, of the outermost @file token
+             * @param err set to ParseErrc::RESPONSE_FILE_TOO_DEEP if the response files are nested too deeply
+             * @return true if a token was found
+             * @return false at the end of the input or on error
+             */
+            bool next(std::string_view& token, int& index, ParseError& err) {
+                for (;;) {
+                    std::string_view tok;
+                    if (!stack.empty()) {
+                        if (!_nextInFile(stack.back(), tok)) {
+                            stack.pop_back();
+                            continue;
+                        }
+                    }
+                    else if (argvIndex + 1 < argc) tok = argv[++argvIndex];
+                    else return false;
+
+                    if (files != nullptr && tok.size() > 1 && tok[0] == '@') {
+                        if (stack.size() == maxResponseFileDepth) {
+                            err = ParseError{ParseErrc::RESPONSE_FILE_TOO_DEEP, argvIndex, tok};
+                            return false;
+                        }
+                        MappedFile file;
+                        if (file.map(std::pmr::string(tok.substr(1), stack.get_allocator()).c_str())) {
+                            LIBCLIPARSER_STATS_ONLY(allocations += (files->size() == files->capacity()) + (stack.size() == stack.capacity());)
+                            // moving a MappedFile does not move the mapped memory: the ranges in stack stay valid
+                            files->push_back(std::move(file));
+                            stack.push_back({files->back().data(), files->back().data() + files->back().size()});
+                            continue;
+                        }
+                        // as gcc does, a file that cannot be read is an ordinary token
+                    }
+                    token = tok;
+                    index = argvIndex;
+                    LIBCLIPARSER_STATS_ONLY(++tokens;)
+                    return true;
+                }
+            }
+
+            /**
+             * @brief check whether the last token returned by next comes from a response file
+             * 
+             * @return true if the token comes from a response file
+             * @return false if it is a token of argv
+             */
+            [[nodiscard]] bool inResponseFile() const noexcept {return !stack.empty();}
+
+            /**
+             * @brief stop the expansion of the @file tokens: the next tokens are returned as they are. The response files being read are read to the end
+             * 
+             */
+            void disableExpansion() noexcept {files = nullptr;}
+
+#ifdef LIBCLIPARSER_STATS
+            std::size_t tokens = 0;  ///< the tokens returned by next
+            std::size_t allocations = 0;  ///< the growths of the list of mapped files and of the stack of response files
+#endif
 
-        if (std::string::size_type pos = opt.find_first_of("= "); pos != std::string::npos) throw BadOptionFormatError(opt);
+            private:
+            struct Range {
+                char* pos;  ///< the first byte that has not been tokenized yet
+                char* end;  ///< the end of the file
+            };
+
+            static bool _isSpace(char c) noexcept {return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';}
+
+            /**
+             * @brief extract the next token of a response file. Quotes and backslashes are removed in place: 
+             * bytes are written only when the token is shorter than its source, so tokens without them do not dirty (copy) the pages of the mapping
+             * 
+             * @param r the unread part of the file
+             * @param token the token, pointing into the mapping
+             * @return true if a token was found
+             * @return false at the end of the file
+             */
+            static bool _nextInFile(Range& r, std::string_view& token) noexcept {
+                char* p = r.pos;
+                while (p != r.end && _isSpace(*p)) ++p;
+                if (p == r.end) {
+                    r.pos = p;
+                    return false;
+                }
+
+                char* const begin = p;
+                char* out = p;
+                char quote = '\0';
+                for (; p != r.end; ++p) {
+                    char c = *p;
+                    if (c == '\\' && p + 1 != r.end) c = *++p;  // the escaped character is taken literally, inside and outside quotes
+                    else if (quote != '\0' && c == quote) {
+                        quote = '\0';
+                        continue;
+                    }
+                    else if (quote == '\0' && (c == '"' || c == '\'')) {
+                        quote = c;
+                        continue;
+                    }
+                    else if (quote == '\0' && _isSpace(c)) break;
+
+                    if (out != p) *out = c;
+                    ++out;
+                }
+
+                r.pos = p;
+                token = std::string_view(begin, static_cast<std::size_t>(out - begin));
+                return true;
+            }
+
+            int argc;
+            char** argv;
+            int argvIndex = 0;  ///< the index of the last token taken from argv
+            std::pmr::vector<Range> stack;  ///< the response files being read, the innermost last
+            std::pmr::vector<MappedFile>* files;
+        };
+
+        /**
+         * @brief FNV-1a hash of bytes, combined with hash
+         * 
+         */
+        std::uint64_t fnv1a(std::uint64_t hash, const void* data, std::size_t n) noexcept {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (std::size_t k = 0; k < n; ++k) hash = (hash ^ bytes[k]) * 0x100000001b3ULL;
+            return hash;
+        }
+
+        /**
+         * @brief the hash of an empty schema: the sizes of the types whose size depends on the platform (see CliParser::schemaHash)
+         * 
+         */
+        std::uint64_t emptySchemaHash() noexcept {
+            const std::uint8_t sizes[] = {sizeof(int), sizeof(long), sizeof(long long), sizeof(float), sizeof(double), sizeof(long double), sizeof(void*)};
+            return fnv1a(0xcbf29ce484222325ULL, sizes, sizeof(sizes));
+        }
     }
 
-    CliParser& CliParser::flag(const std::string& opt, const std::string& description) {
-        if(hasOption(opt)) throw OptionRedefinitionError(opt);
+    char* _detail::StringPool::_allocate(std::size_t size) {
+        const bool oversized = size > chunkSize - sizeof(Chunk);
+        const std::size_t bytes = oversized ? sizeof(Chunk) + size : chunkSize;
+        Chunk* chunk = static_cast<Chunk*>(resource->allocate(bytes, alignof(Chunk)));
+        chunk->next = head;
+        chunk->size = bytes;
+        head = chunk;
+        char* first = reinterpret_cast<char*>(chunk + 1);
+        // a long string fills a chunk of its own: the free space of the current chunk is kept. Otherwise, the rest of the current chunk (smaller than the string) is wasted
+        if (!oversized) {
+            pos = first + size;
+            end = first + (bytes - sizeof(Chunk));
+        }
+        return first;
+    }
 
-        cliOptions.insert_or_assign(opt, new Option<bool>(description, false, true));
+    void _detail::StringPool::_release() noexcept {
+        while (head != nullptr) {
+            Chunk* next = head->next;
+            resource->deallocate(head, head->size, alignof(Chunk));
+            head = next;
+        }
+        pos = end = nullptr;
+    }
+
+    std::size_t _detail::SmallIndex::find(std::string_view key, const std::string_view* names) const noexcept {
+        const std::uint32_t tag = _tag(key);
+        std::uint32_t candidates = 0;  // bit i is set if the tag of the name i is the tag of key
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i wanted = _mm_set1_epi32(static_cast<int>(tag));
+        for (std::size_t k = 0; k < capacity; k += 4) {
+            const __m128i block = _mm_load_si128(reinterpret_cast<const __m128i*>(tags + k));
+            candidates |= static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, wanted)))) << k;
+        }
+#else
+        for (std::size_t k = 0; k < capacity; ++k) candidates |= static_cast<std::uint32_t>(tags[k] == tag) << k;  // no branches: the loop is vectorized by the compiler
+#endif
+        candidates &= (std::uint32_t(1) << count) - 1;  // the unused tags are zero, like the tag of an empty key
+
+        for (; candidates != 0; candidates &= candidates - 1) {
+            const std::size_t i = static_cast<std::size_t>(std::countr_zero(candidates));
+            if (names[i] == key) return i;
+        }
+        return npos;
+    }
+
+    CliParser::CliParser(std::string_view program, std::string_view description, std::string_view version, const allocator_type& alloc) 
+        : strings(alloc.resource()), appName(strings.intern(program)), descr(strings.intern(description)), ver(strings.intern(version)), envNames(alloc), configNames(alloc), configFiles(alloc), subcommands(alloc), subcommandNames(alloc), 
+        helpCache(alloc), digest(emptySchemaHash()), cliOptions(alloc), names(alloc), sortedNames(alloc), sortedIndices(alloc), requiredBits(alloc.resource()), flagBits(alloc.resource()), options(alloc), own(*this, alloc.resource()) {}
+
+    CliParser::CliParser(CliParser&& other) noexcept 
+        : strings(std::move(other.strings)), appName(other.appName), descr(other.descr), ver(other.ver), responseFiles(other.responseFiles), lazy(other.lazy), abbreviations(other.abbreviations), positional(other.positional), 
+        envNames(std::move(other.envNames)), configNames(std::move(other.configNames)), configFiles(std::move(other.configFiles)), envp(other.envp), helpColumns(other.helpColumns), 
+        subcommands(std::move(other.subcommands)), subcommandNames(std::move(other.subcommandNames)), 
+#ifdef LIBCLIPARSER_STATS
+        statsHook(std::move(other.statsHook)), schemaBuildTime(other.schemaBuildTime), 
+#endif
+        helpCache(std::move(other.helpCache)), digest(other.digest), smallIndex(other.smallIndex), cliOptions(std::move(other.cliOptions)), names(std::move(other.names)), sortedNames(std::move(other.sortedNames)), sortedIndices(std::move(other.sortedIndices)), 
+        requiredBits(std::move(other.requiredBits)), flagBits(std::move(other.flagBits)), options(std::move(other.options)), own(std::move(other.own)) {
+        // the chunks of strings are taken over: all the views stay valid
+        own.schema = this;
+        other.smallIndex = _detail::SmallIndex();  // names are empty in other: a stale index would read them
+        other.digest = emptySchemaHash();
+    }
+
+    CliParser& CliParser::operator=(CliParser&& other) {
+        if (this == &other) return *this;
+        strings = std::move(other.strings);
+        appName = other.appName;
+        descr = other.descr;
+        ver = other.ver;
+        responseFiles = other.responseFiles;
+        lazy = other.lazy;
+        abbreviations = other.abbreviations;
+        positional = other.positional;
+        envNames = std::move(other.envNames);
+        configNames = std::move(other.configNames);
+        configFiles = std::move(other.configFiles);
+        envp = other.envp;
+        helpColumns = other.helpColumns;
+        subcommands = std::move(other.subcommands);
+        subcommandNames = std::move(other.subcommandNames);
+#ifdef LIBCLIPARSER_STATS
+        statsHook = std::move(other.statsHook);
+        schemaBuildTime = other.schemaBuildTime;
+#endif
+        helpCache = std::move(other.helpCache);
+        digest = std::exchange(other.digest, emptySchemaHash());
+        smallIndex = other.smallIndex;
+        other.smallIndex = _detail::SmallIndex();
+        cliOptions = std::move(other.cliOptions);
+        names = std::move(other.names);
+        sortedNames = std::move(other.sortedNames);
+        sortedIndices = std::move(other.sortedIndices);
+        requiredBits = std::move(other.requiredBits);
+        flagBits = std::move(other.flagBits);
+        options = std::move(other.options);
+        own = std::move(other.own);
+        own.schema = this;
+        // the keys of the dictionaries are views: even if they are copied into the memory resource of this object, they still refer to the chunks of strings, which are taken over
+        return *this;
+    }
+
+    void CliParser::_preliminaryCheckOptionForProblems(std::string_view opt) const {
+        if(hasOption(opt) || subcommandNames.contains(opt)) LIBCLIPARSER_THROW(OptionRedefinitionError(opt));
+
+        if (std::string_view::size_type pos = opt.find_first_of("= "); pos != std::string_view::npos) LIBCLIPARSER_THROW(BadOptionFormatError(opt));
+    }
+
+    void CliParser::_hashLastOption() noexcept {
+        const size_type i = options.size() - 1;
+        const std::uint64_t length = names[i].size();
+        const std::uint8_t tags[] = {static_cast<std::uint8_t>(options[i].index()), static_cast<std::uint8_t>(requiredBits.test(i) | (flagBits.test(i) << 1))};
+        digest = fnv1a(digest, &length, sizeof(length));
+        digest = fnv1a(digest, names[i].data(), names[i].size());
+        digest = fnv1a(digest, tags, sizeof(tags));
+        if (const Option<_detail::UserValue>* user = std::get_if<Option<_detail::UserValue>>(&options[i])) {
+            // all the user-defined types share one alternative: their identity tells them apart
+            const std::uint64_t size = user->arg.typeSize();
+            const std::string_view type = user->arg.typeName();
+            digest = fnv1a(digest, &size, sizeof(size));
+            digest = fnv1a(digest, type.data(), type.size());
+        }
+    }
+
+    CliParser& CliParser::flag(std::string_view opt, std::string_view description) {
+        if(hasOption(opt) || subcommandNames.contains(opt)) LIBCLIPARSER_THROW(OptionRedefinitionError(opt));
+
+        _addOption(opt, Option<bool>(description, false, true));
 
         return *this;
     }
 
-    CliParser& CliParser::flag(const std::string& opt, std::string&& description) {
-        if(hasOption(opt)) throw OptionRedefinitionError(opt);
+    CliParser& CliParser::subcommand(std::string_view name, std::string_view description, std::function<void(CliParser&)> factory) {
+        if (hasOption(name) || subcommandNames.contains(name)) LIBCLIPARSER_THROW(OptionRedefinitionError(name));
 
-        cliOptions.insert_or_assign(opt, new Option<bool>(std::move(description), false, true));
+        subcommands.push_back(std::make_unique<Subcommand>());
+        Subcommand& sub = *subcommands.back();
+        sub.name = strings.intern(name);
+        sub.descr = strings.intern(description);
+        sub.factory = std::move(factory);
+        subcommandNames.emplace(sub.name, subcommands.size() - 1);
+        helpCache.width = 0;  // the help lists the subcommands
 
         return *this;
     }
 
+    const CliParser* CliParser::subcommandParser(std::string_view name) const {
+        const_option_iterator it = subcommandNames.find(name);
+        if (it == subcommandNames.end()) return nullptr;
+        // the pointer is set inside std::call_once: read it only if the parser has been built by this thread or it is not being built
+        return subcommands[it->second]->parser.get();
+    }
+
+    ParseError CliParser::_parseSubcommand(size_type sub, int argc, char* argv[], int offset, ParseResult& result, bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError) const {
+        Subcommand& s = *subcommands[sub];
+        std::call_once(s.built, [this, &s]() {
+            std::pmr::string program(appName, get_allocator());
+            program += ' ';
+            program += s.name;
+            std::unique_ptr<CliParser> parser = std::make_unique<CliParser>(program, s.descr, ver, get_allocator());
+            parser->responseFiles = responseFiles;
+            parser->lazy = lazy;
+            parser->abbreviations = abbreviations;
+            parser->positional = positional;
+            parser->envp = envp;
+            parser->helpColumns = helpColumns;
+            s.factory(*parser);
+            s.parser = std::move(parser);  // only a completely built parser is published
+        });
+
+        result.selected = sub;
+        ParseError err;
+        if (&result == &own) err = s.parser->tryParse(argc, argv, ignoreUnknownOptions, suppressMissingRequiredOptionsError);
+        else {
+            // the result of the subcommand is reused if it belongs to the same subcommand
+            if (result.subResult.empty()) result.subResult.emplace_back(*s.parser);
+            else if (result.subResult.front().schema != s.parser.get()) result.subResult.front() = ParseResult(*s.parser);
+            else result.subResult.front().reset();
+            err = s.parser->tryParse(argc, argv, result.subResult.front(), ignoreUnknownOptions, suppressMissingRequiredOptionsError);
+        }
+        if (err.index > 0) err.index += offset;  // the indices of the errors refer to the whole command line
+        return err;
+    }
+
 
     void CliParser::parse(int argc, char* argv[], bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError) { 
-        if (argc == 0) return;  // handle corner case: argc == 0. If this is the case, do nothing
-        executablePath = argv[0];
-        int i = 1;
-        while (i < argc) {
-
-            std::string_view view(argv[i]);
-
-            if (std::string_view::size_type pos = view.find_first_of('='); pos != std::string_view::npos) {
-                // there is an '=' in the argv, so we need to split, read find the argument and then parse its value
-                option_iterator it = cliOptions.find(std::string(view.begin(), view.begin()+pos));
-
-                // handle the "missing argument" case
-                if (it == cliOptions.end()) {
-                    // if we cannot ignore unknown args, we need to throw the NoSuchOptionException exception; otherwise, we simply skip it
-                    if(!ignoreUnknownOptions) throw NoSuchOptionException(std::string(view.begin(), view.begin()+pos));
-                    ++i;
+        parse(argc, argv, own, ignoreUnknownOptions, suppressMissingRequiredOptionsError);
+    }
+
+    void CliParser::parse(int argc, char* argv[], ParseResult& result, bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError) const { 
+#ifdef LIBCLIPARSER_STATS
+        ParseError err = _tryParseWithStats(argc, argv, result, ignoreUnknownOptions, suppressMissingRequiredOptionsError, true);
+#else
+        ParseError err = _tryParse(argc, argv, result, ignoreUnknownOptions, suppressMissingRequiredOptionsError);
+#endif
+        
+        // translate the error into the corresponding exception. The message is built only here, on the error path
+        switch (err.code) {
+            case ParseErrc::OK: return;
+            case ParseErrc::NO_SUCH_OPTION: LIBCLIPARSER_THROW(NoSuchOptionException(err.option));
+            case ParseErrc::MISSING_REQUIRED_OPTION: LIBCLIPARSER_THROW(MissingRequiredOptionsError(_missingRequiredOptions(result)));
+            case ParseErrc::VALUE_OUT_OF_RANGE: LIBCLIPARSER_THROW(std::out_of_range(err.message()));
+            default: LIBCLIPARSER_THROW(std::invalid_argument(err.message()));
+        }
+    }
+
+    ParseError CliParser::tryParse(int argc, char* argv[], bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError) { 
+        return tryParse(argc, argv, own, ignoreUnknownOptions, suppressMissingRequiredOptionsError);
+    }
+
+    ParseError CliParser::tryParse(int argc, char* argv[], ParseResult& result, bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError) const { 
+#ifdef LIBCLIPARSER_STATS
+        return _tryParseWithStats(argc, argv, result, ignoreUnknownOptions, suppressMissingRequiredOptionsError, false);
+#else
+        return _tryParse(argc, argv, result, ignoreUnknownOptions, suppressMissingRequiredOptionsError);
+#endif
+    }
+
+#ifdef LIBCLIPARSER_STATS
+    ParseError CliParser::_tryParseWithStats(int argc, char* argv[], ParseResult& result, bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError, bool throwing) const {
+        result.parseStats = ParseStats();
+        result.parseStats.schemaBuild = schemaBuildTime;
+        std::chrono::nanoseconds total{};
+        ParseError err;
+        {
+            _detail::PhaseTimer timer(total);
+            err = _tryParse(argc, argv, result, ignoreUnknownOptions, suppressMissingRequiredOptionsError);
+        }
+        // the conversions and the required check are timed on their own: the rest is the reading of the input
+        result.parseStats.tokenization = total - result.parseStats.conversion - result.parseStats.requiredCheck;
+        if (throwing && err) ++result.parseStats.exceptions;
+        if (statsHook) statsHook(result.parseStats);
+        return err;
+    }
+#endif
+
+    ParseError CliParser::_tryParse(int argc, char* argv[], ParseResult& result, bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError) const { 
+        result._sync();  // options may have been added after the creation of result
+        // the positional arguments are those of this parse. A single reserve covers argv: the tokens of the response files grow the vector geometrically
+        result.positionalArgs.clear();
+        result.remainderBegin = static_cast<std::size_t>(-1);
+        if (positional && argc > 1) result.positionalArgs.reserve(static_cast<std::size_t>(argc - 1));
+        if (argc == 0) return ParseError();  // handle corner case: argc == 0. If this is the case, do nothing
+        result.exePath = argv[0];
+
+        // the configuration files are applied first, then the environment: the command line, parsed last, takes precedence
+        for (const std::pair<std::pmr::string, bool>& file : configFiles) {
+            if (ParseError configErr = _readConfigFile(file.first, file.second, result, ignoreUnknownOptions)) return configErr;
+        }
+
+        if (!envNames.empty()) {
+            for (char** entry = envp != nullptr ? envp : LIBCLIPARSER_ENVIRON; entry != nullptr && *entry != nullptr; ++entry) {
+                // one pass over the environment, one lookup of each variable name in the table of the names declared with CliParser::env
+                std::string_view var(*entry);
+                std::string_view::size_type eq = var.find('=');
+                if (eq == std::string_view::npos) continue;
+                env_dictionary::const_iterator it = envNames.find(var.substr(0, eq));
+                LIBCLIPARSER_STATS_ONLY(++result.parseStats.lookups;)
+                if (it == envNames.end()) continue;
+
+                std::string_view input = var.substr(eq + 1);
+                std::errc ec = _assign(result, it->second, input, OptionSource::ENVIRONMENT);
+                if (ec != std::errc()) return ParseError{conversionError(ec), -1, names[it->second], input};
+                result.setByUser.set(it->second);
+                result.fromEnvironment.set(it->second);
+                result.fromConfigFile.reset(it->second);
+            }
+        }
+
+        ParseError err;
+        TokenCursor cursor(argc, argv, responseFiles ? &result.mappedFiles : nullptr, result.mappedFiles.get_allocator().resource());
+        int index;
+        std::string_view view;
+        while (cursor.next(view, index, err)) {
+            if (positional && view == "--") {
+                // the remainder: the rest of the input is taken literally
+                result.remainderBegin = result.positionalArgs.size();
+                cursor.disableExpansion();
+                while (cursor.next(view, index, err)) result.positionalArgs.push_back(view);
+                break;
+            }
+
+            // if there is an '=' in the argv, we need to split: the key is the option and the rest is its value
+            std::string_view::size_type pos = view.find_first_of('=');
+            std::string_view key = (pos != std::string_view::npos) ? view.substr(0, pos) : view;
+
+            // the lookup is done on the view: no temporary std::string is built
+            size_type optIndex = _findOption(key);
+            LIBCLIPARSER_STATS_ONLY(result.parseStats.lookups += 1 + (optIndex == noOption && abbreviations);)
+            if (optIndex == noOption) {
+                if (std::span<const std::string_view> matches = (abbreviations && key.size() > 2 && key.starts_with("--")) ? complete(key) : std::span<const std::string_view>(); !matches.empty()) {
+                    // GNU-style abbreviation: the key must be the prefix of exactly one option
+                    if (matches.size() > 1) return ParseError{ParseErrc::AMBIGUOUS_OPTION, index, key};
+                    optIndex = sortedIndices[static_cast<size_type>(matches.data() - sortedNames.data())];
+                    key = names[optIndex];  // the errors report the full name
+                }
+                else if (const_option_iterator sub = (!subcommands.empty() && pos == std::string_view::npos && !cursor.inResponseFile()) ? subcommandNames.find(view) : subcommandNames.end(); sub != subcommandNames.end()) {
+                    // the rest of argv belongs to the subcommand: its argv[0] is the name of the subcommand
+                    if (ParseError subErr = _parseSubcommand(sub->second, argc - index, argv + index, index, result, ignoreUnknownOptions, suppressMissingRequiredOptionsError)) return subErr;
+                    break;
+                }
+                else if (positional && (view.empty() || view[0] != '-' || view.size() == 1)) {
+                    // a positional argument (the whole token, '=' included). "-" usually means the standard input
+                    result.positionalArgs.push_back(view);
                     continue;
-                    
                 }
-
-                if (it->second->isFlag()) {
-                    // handle error: flags cannot be set explicitly
-                    throw std::invalid_argument("\033[1;31merror: invalid input\033[0m. Attempted to assign a value to a flag with '='");
+                else {
+                    // handle the "missing argument" case
+                    // if we cannot ignore unknown args, we need to report the error; otherwise, we simply skip it
+                    if (!ignoreUnknownOptions) return ParseError{ParseErrc::NO_SUCH_OPTION, index, key};
+                    continue;
                 }
-                else it->second->setArgFromInput(argv[i++]+pos+1);
+            }
 
+            if (flagBits.test(optIndex)) {  
+                // flags must be handled differently from regular options: they cannot be set explicitly
+                if (pos != std::string_view::npos) return ParseError{ParseErrc::FLAG_WITH_VALUE, index, key};
+
+                result.values[optIndex] = true;  // flags are always bool. They do not consume additional arguments and simply set the value to true
+                result.pending[optIndex] = std::string_view();  // a lazy value from the environment or a configuration file must not be converted later
+                result.setByUser.set(optIndex);
+                result.fromEnvironment.reset(optIndex);
+                result.fromConfigFile.reset(optIndex);
+                continue;
             }
-            else {
-                option_iterator it = cliOptions.find(argv[i++]);
 
-                if (it == cliOptions.end()) {
-                    // if we cannot ignore unknown args, we need to throw the NoSuchOptionException exception; otherwise, we simply skip it
-                    if(!ignoreUnknownOptions) throw NoSuchOptionException(argv[i-1]);
-                    continue;
+            // the value is either after the '=' or the next token
+            int valueIndex = index;
+            std::string_view input;
+            if (pos != std::string_view::npos) input = view.substr(pos+1);
+            else if (!cursor.next(input, valueIndex, err)) return err ? err : ParseError{ParseErrc::MISSING_VALUE, index, key};
+
+            std::errc ec = _assign(result, optIndex, input, OptionSource::COMMAND_LINE);
+            if (ec != std::errc()) return ParseError{conversionError(ec), valueIndex, key, input};
+            result.setByUser.set(optIndex);
+            result.fromEnvironment.reset(optIndex);  // the command line overrides the environment and the configuration files
+            result.fromConfigFile.reset(optIndex);
+        }
+        LIBCLIPARSER_STATS_ONLY(result.parseStats.tokens += cursor.tokens; result.parseStats.allocations += cursor.allocations;)
+        if (err) return err;
+
+        // one masked compare per 64 options: the name is looked up only if a required option is missing
+        if (!suppressMissingRequiredOptionsError) {
+            LIBCLIPARSER_STATS_ONLY(_detail::PhaseTimer timer(result.parseStats.requiredCheck);)
+            if (size_type missing = result.setByUser.firstMissing(requiredBits); missing != _detail::DynamicBitset::npos) return ParseError{ParseErrc::MISSING_REQUIRED_OPTION, -1, names[missing]};
+        }
+
+        return ParseError();
+    }
+
+    std::vector<ParseError> CliParser::tryParseBatch(std::span<const std::span<char*>> lines, std::vector<ParseResult>& results, unsigned int threads, bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError) const {
+        // the results are prepared here, by the calling thread: the workers only touch their own lines
+        if (results.size() > lines.size()) results.erase(results.begin() + lines.size(), results.end());
+        for (ParseResult& r : results) {
+            if (r.schema == this) r.reset();
+            else r = ParseResult(*this);  // a result of another parser
+        }
+        results.reserve(lines.size());
+        while (results.size() < lines.size()) results.emplace_back(*this);
+
+        std::vector<ParseError> errors(lines.size());
+
+        /*
+            dynamic scheduling: the lines are split into chunks of chunkSize lines, and each thread claims the next unparsed chunk with a single fetch_add.
+            Command lines of very different lengths are balanced as with work stealing, but without per-thread queues
+        */
+        constexpr std::size_t chunkSize = 64;
+        std::atomic<std::size_t> next = 0;
+        auto work = [&]() {
+            for (std::size_t begin = next.fetch_add(chunkSize, std::memory_order_relaxed); begin < lines.size(); begin = next.fetch_add(chunkSize, std::memory_order_relaxed)) {
+                const std::size_t end = std::min(begin + chunkSize, lines.size());
+                for (std::size_t i = begin; i < end; ++i) {
+                    errors[i] = tryParse(static_cast<int>(lines[i].size()), lines[i].data(), results[i], ignoreUnknownOptions, suppressMissingRequiredOptionsError);
+                }
+            }
+        };
+
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        // no thread is started for work that one chunk covers
+        threads = static_cast<unsigned int>(std::min<std::size_t>(threads, (lines.size() + chunkSize - 1) / chunkSize));
+
+        std::vector<std::thread> pool;
+        pool.reserve(threads > 0 ? threads - 1 : 0);
+        for (unsigned int t = 1; t < threads; ++t) pool.emplace_back(work);
+        work();  // the calling thread works too
+        for (std::thread& t : pool) t.join();
+
+        return errors;
+    }
+
+    template <_detail::StoredArgument Argument>
+    std::errc CliParser::_convertConstrained(std::string_view input, Argument& value, const std::function<bool(const Argument&)>& constraint) {
+        Argument converted(value);  // a copy: e.g. a _detail::UserValue carries the conversion of its type
+        std::errc ec = _convertArg(input, converted);
+        if (ec != std::errc()) return ec;
+        if (!constraint(converted)) return std::errc::argument_out_of_domain;
+        value = std::move(converted);
+        return std::errc();
+    }
+
+    std::errc CliParser::_assign(ParseResult& result, size_type optIndex, std::string_view input, OptionSource source) const {
+        // std::visit dispatches on the variant index (the type tag of the option). The value is modified only if the conversion succeeds
+        return std::visit([this, input, optIndex, source, &result](auto& value) {
+            // the parser's own result writes a bound option straight into its target (see CliParser::bind)
+            using Argument = std::remove_cvref_t<decltype(value)>;
+            const Option<Argument>& o = *std::get_if<Option<Argument>>(&options[optIndex]);
+            Argument* target = (&result == &own) ? o.target : nullptr;
+            Argument& dest = target != nullptr ? *target : value;
+            result.pending[optIndex] = std::string_view();
+            if (lazy && target == nullptr && !_detail::is_number_list<Argument> && !o.constraint) {
+                // lazy conversion: keep the raw token. It points into argv, a response file or the environment, therefore it is never a null view, even if empty ("-s=")
+                result.pending[optIndex] = input;
+                return std::errc();
+            }
+#ifdef LIBCLIPARSER_STATS
+            _detail::PhaseTimer timer(result.parseStats.conversion);
+            ++result.parseStats.conversions[_detail::argument_index<Argument>];
+            if constexpr (std::same_as<Argument, std::string>) result.parseStats.allocations += input.size() > dest.capacity();
+            std::size_t capacity = 0;
+            if constexpr (_detail::is_number_list<Argument>) capacity = dest.capacity();
+#endif
+            std::errc ec;
+            if constexpr (_detail::is_number_list<Argument>) {
+                // a repeated list option appends, unless the current values come from a source of lower precedence (or are the default)
+                const bool append = source == OptionSource::COMMAND_LINE 
+                    ? result.setByUser.test(optIndex) && !result.fromEnvironment.test(optIndex) && !result.fromConfigFile.test(optIndex)
+                    : source == OptionSource::CONFIG_FILE && result.fromConfigFile.test(optIndex);
+                if (!append) ec = o.constraint ? _convertConstrained(input, dest, o.constraint) : _convertList(input, dest);
+                else {
+                    // the list is checked as a whole, after the new values are appended: they are removed on a violation
+                    const std::size_t size = dest.size();
+                    ec = _appendList(input, dest);
+                    if (ec == std::errc() && o.constraint && !o.constraint(dest)) {
+                        dest.resize(size);
+                        ec = std::errc::argument_out_of_domain;
+                    }
                 }
+            }
+            else if (o.constraint) ec = _convertConstrained(input, dest, o.constraint);
+            else ec = _convertArg(input, dest);
+            LIBCLIPARSER_STATS_ONLY(if constexpr (_detail::is_number_list<Argument>) result.parseStats.allocations += dest.capacity() != capacity;)
+            return ec;
+        }, result.values[optIndex]);
+    }
+
+    ParseError CliParser::_readConfigFile(const std::pmr::string& path, bool required, ParseResult& result, bool ignoreUnknownOptions) const {
+        MappedFile file;
+        if (!file.map(path.c_str())) {
+            // the non-throwing overload: an error (e.g. a parent directory that cannot be searched) is reported as BAD_CONFIG_FILE
+            std::error_code ec;
+            if (!required && !std::filesystem::exists(path, ec) && !ec) return ParseError();
+            // the path is owned by this CliParser: the view stays valid
+            return ParseError{ParseErrc::BAD_CONFIG_FILE, 0, path};
+        }
+        LIBCLIPARSER_STATS_ONLY(result.parseStats.allocations += result.mappedFiles.size() == result.mappedFiles.capacity();)
+        result.mappedFiles.push_back(std::move(file));
+        const std::string_view content = result.mappedFiles.back().view();
+
+        constexpr std::string_view spaces = " \t\r\f\v";
+        auto trim = [spaces](std::string_view v) {
+            std::string_view::size_type first = v.find_first_not_of(spaces);
+            if (first == std::string_view::npos) return std::string_view();
+            return v.substr(first, v.find_last_not_of(spaces) - first + 1);
+        };
 
-                if (it->second->isFlag()) {  
-                    // flags must be handled differently from regular options
-                    static_cast<Option<bool>*>(it->second)->arg = true;  // flags do not consume additional arguments and simply set the value to true
-                    /*
-                        the option is still a flag, but its OptionBase::OPTION_INFO must change from FLAG to FLAG_OVERRIDEN_BY_USER 
-                        Here, info is set directly to FLAG_OVERRIDEN_BY_USER, but we could have obtained the same result by using it->second->info |= SET_BY_USER
-                        (remember: FLAG_OVERRIDEN_BY_USER = FLAG | SET_BY_USER)
-                    */
-                    it->second->info = OptionBase::FLAG_OVERRIDEN_BY_USER;  
+        std::string_view section;  // the current section, without brackets
+        int lineNumber = 0;
+        _detail::DynamicBitset listsInFile(result.mappedFiles.get_allocator().resource());  // the list options set by this file, sized on the first list
+        for (std::string_view::size_type begin = 0; begin < content.size(); ) {
+            // one forward pass: each line is a view of the mapping
+            std::string_view::size_type end = std::min(content.find('\n', begin), content.size());
+            std::string_view line = trim(content.substr(begin, end - begin));
+            begin = end + 1;
+            ++lineNumber;
+
+            if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+            if (line[0] == '[') {
+                if (line.back() != ']') return ParseError{ParseErrc::BAD_CONFIG_FILE, lineNumber, line};
+                section = trim(line.substr(1, line.size() - 2));
+                continue;
+            }
+
+            std::string_view::size_type eq = line.find('=');
+            if (eq == std::string_view::npos) return ParseError{ParseErrc::BAD_CONFIG_FILE, lineNumber, line};
+            std::string_view key = trim(line.substr(0, eq)), value = trim(line.substr(eq + 1));
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"') value = value.substr(1, value.size() - 2);
+
+            option_dictionary::const_iterator it;
+            if (section.empty()) it = configNames.find(key);
+            else {
+                // build "section.key" without allocating for the common case of short names
+                char buffer[256];
+                if (section.size() + 1 + key.size() > sizeof(buffer)) it = configNames.find(std::string(section) + "." + std::string(key));
+                else {
+                    std::copy(section.begin(), section.end(), buffer);
+                    buffer[section.size()] = '.';
+                    std::copy(key.begin(), key.end(), buffer + section.size() + 1);
+                    it = configNames.find(std::string_view(buffer, section.size() + 1 + key.size()));
                 }
-                else it->second->setArgFromInput(argv[i++]);  
+            }
+            LIBCLIPARSER_STATS_ONLY(++result.parseStats.lookups;)
+            if (it == configNames.end()) {
+                if (!ignoreUnknownOptions) return ParseError{ParseErrc::NO_SUCH_OPTION, lineNumber, key};
+                continue;
+            }
 
+            if (std::visit([](const auto& o) {return _detail::is_number_list<std::remove_cvref_t<decltype(o.arg)>>;}, options[it->second])) {
+                // a list appends within a file, but its first occurrence in a file replaces the values of the earlier files
+                if (listsInFile.size() == 0) listsInFile.resize(options.size());
+                if (!listsInFile.test(it->second)) {
+                    listsInFile.set(it->second);
+                    result.fromConfigFile.reset(it->second);
+                }
             }
+            std::errc ec = _assign(result, it->second, value, OptionSource::CONFIG_FILE);
+            if (ec != std::errc()) return ParseError{conversionError(ec), lineNumber, names[it->second], value};
+            result.setByUser.set(it->second);
+            result.fromConfigFile.set(it->second);
         }
 
-        if (!suppressMissingRequiredOptionsError) {
-            std::vector<std::string> missingReqOpt;
-            for (option_iterator it = cliOptions.begin(); it != cliOptions.end(); ++it) {
-                if (!it->second->good()) missingReqOpt.emplace_back(it->first); 
+        return ParseError();
+    }
+
+    void ParseResult::reset() {
+        _sync();
+        for (CliParser::size_type i = 0; i < values.size(); ++i) {
+            // assigning the value of the same alternative reuses the storage (e.g. the buffer of a std::string)
+            std::visit([this, i](const auto& o) {
+                using Argument = std::remove_cvref_t<decltype(o.arg)>;
+                if (o.target == nullptr || !_isOwn()) std::get<Argument>(values[i]) = o.arg;  // targets are never reset
+            }, schema->options[i]);
+        }
+        setByUser.clear();
+        fromEnvironment.clear();
+        fromConfigFile.clear();
+        pending.assign(pending.size(), std::string_view());
+        exePath = std::string_view();
+        positionalArgs.clear();
+        remainderBegin = static_cast<std::size_t>(-1);
+        mappedFiles.clear();
+        if (selected != static_cast<std::size_t>(-1) && _isOwn()) schema->subcommands[selected]->parser->reset();
+        else if (!subResult.empty()) subResult.front().reset();
+        selected = static_cast<std::size_t>(-1);
+    }
+
+    std::string_view ParseResult::subcommand() const noexcept {
+        return selected != static_cast<std::size_t>(-1) ? std::string_view(schema->subcommands[selected]->name) : std::string_view();
+    }
+
+    const ParseResult* ParseResult::subcommandResult() const noexcept {
+        if (selected == static_cast<std::size_t>(-1)) return nullptr;
+        return _isOwn() ? &schema->subcommands[selected]->parser->own : &subResult.front();
+    }
+
+    void ParseResult::_convertPending(std::size_t i, std::string_view opt) const {
+        std::errc ec = std::visit([this, i](auto& value) {
+#ifdef LIBCLIPARSER_STATS
+            using Argument = std::remove_cvref_t<decltype(value)>;
+            _detail::PhaseTimer timer(parseStats.conversion);
+            ++parseStats.conversions[_detail::argument_index<Argument>];
+            if constexpr (std::same_as<Argument, std::string>) parseStats.allocations += pending[i].size() > value.capacity();
+#endif
+            return CliParser::_convertArg(pending[i], value);
+        }, values[i]);
+        if (ec == std::errc()) {
+            pending[i] = std::string_view();
+            return;
+        }
+
+        if (opt.empty()) opt = schema->names[i];  // only the handle is known
+        ParseError err{conversionError(ec), -1, opt, pending[i]};
+        LIBCLIPARSER_STATS_ONLY(++parseStats.exceptions;)
+        if (err.code == ParseErrc::VALUE_OUT_OF_RANGE) LIBCLIPARSER_THROW(std::out_of_range(err.message()));
+        LIBCLIPARSER_THROW(std::invalid_argument(err.message()));
+    }
+
+    std::vector<std::string> CliParser::_missingRequiredOptions(const ParseResult& result) const {
+        std::vector<std::string> missingReqOpt;
+        for (size_type i = result.setByUser.firstMissing(requiredBits); i != _detail::DynamicBitset::npos; i = result.setByUser.firstMissing(requiredBits, i + 1)) {
+            missingReqOpt.emplace_back(names[i]); 
+        }
+        // the required options of the subcommand are required too
+        if (const ParseResult* sub = result.subcommandResult(); sub != nullptr) {
+            std::vector<std::string> missingSubOpt = sub->schema->_missingRequiredOptions(*sub);
+            missingReqOpt.insert(missingReqOpt.end(), std::make_move_iterator(missingSubOpt.begin()), std::make_move_iterator(missingSubOpt.end()));
+        }
+        return missingReqOpt;
+    }
+
+    std::string ParseError::message() const {
+        static const std::string invalidInput = "\033[1;31merror: invalid input\033[0m. ";
+        switch (code) {
+            case ParseErrc::OK: return std::string();
+            case ParseErrc::NO_SUCH_OPTION: return std::string("Unrecognised option: ") + std::string(option);
+            case ParseErrc::FLAG_WITH_VALUE: return invalidInput + "Attempted to assign a value to a flag with '='";
+            case ParseErrc::MISSING_VALUE: return invalidInput + "Missing value for the option " + std::string(option);
+            case ParseErrc::INVALID_VALUE: return invalidInput + "Invalid value for the option " + std::string(option) + ": " + std::string(value);
+            case ParseErrc::VALUE_OUT_OF_RANGE: return invalidInput + "Value out of range for the option " + std::string(option) + ": " + std::string(value);
+            case ParseErrc::MISSING_REQUIRED_OPTION: return std::string("\033[1;31merror\033[0m: the option ") + std::string(option) + " is marked as required but no value was provided";
+            case ParseErrc::BAD_CONFIG_FILE: return invalidInput + (index == 0 ? "Cannot read the configuration file " : "Invalid line in a configuration file: ") + std::string(option);
+            case ParseErrc::AMBIGUOUS_OPTION: return invalidInput + "Ambiguous option: " + std::string(option);
+            case ParseErrc::RESPONSE_FILE_TOO_DEEP: return invalidInput + "Response files nested too deeply: " + std::string(option);
+            case ParseErrc::CONSTRAINT_VIOLATION: return invalidInput + "Value rejected by the constraints of the option " + std::string(option) + ": " + std::string(value);
+            case ParseErrc::BAD_SNAPSHOT: return std::string("\033[1;31merror\033[0m: the snapshot is not valid");
+            case ParseErrc::SNAPSHOT_SCHEMA_MISMATCH: return std::string("\033[1;31merror\033[0m: the snapshot was written for another schema");
+        }
+        return std::string();
+    }
+
+    namespace {
+        constexpr std::uint32_t snapshotMagic = 0x53504c43;  ///< "CLPS" in little-endian order. A snapshot written with the other byte order does not match it
+        constexpr std::uint16_t snapshotVersion = 2;  ///< the version of the format of the snapshots
+
+        /**
+         * @brief SnapshotWriter class. It appends bytes to a buffer while they fit, and counts them all
+         * 
+         */
+        class SnapshotWriter {
+            public:
+            explicit SnapshotWriter(std::span<std::byte> out) noexcept : out(out) {}
+
+            void bytes(const void* data, std::size_t n) noexcept {
+                if (n != 0 && size <= out.size() && n <= out.size() - size) std::memcpy(out.data() + size, data, n);
+                size += n;
+            }
+
+            template <typename T>
+            void value(const T& v) noexcept {bytes(&v, sizeof(T));}
+
+            /**
+             * @brief append a count of elements (a length or the size of a list) and the elements
+             * 
+             */
+            template <typename T>
+            void array(const T* data, std::size_t count) noexcept {
+                value(static_cast<std::uint32_t>(count));
+                bytes(data, count * sizeof(T));
             }
+
+            std::size_t size = 0;  ///< the number of bytes appended, including those that did not fit
+
+            private:
+            std::span<std::byte> out;
+        };
+
+        /**
+         * @brief SnapshotReader class. It reads bytes from a snapshot, checking that they are there
+         * 
+         */
+        class SnapshotReader {
+            public:
+            explicit SnapshotReader(std::span<const std::byte> in) noexcept : in(in) {}
+
+            bool bytes(void* data, std::size_t n) noexcept {
+                if (n > in.size() - pos) return false;
+                if (n != 0) std::memcpy(data, in.data() + pos, n);
+                pos += n;
+                return true;
+            }
+
+            template <typename T>
+            bool value(T& v) noexcept {return bytes(&v, sizeof(T));}
+
+            /**
+             * @brief read a count of elements written by SnapshotWriter::array and skip the elements
+             * 
+             * @param elementSize the size of an element
+             * @param count the count
+             * @return const std::byte* the first element, or nullptr if the snapshot is truncated
+             */
+            const std::byte* array(std::size_t elementSize, std::size_t& count) noexcept {
+                std::uint32_t n;
+                if (!value(n) || n > (in.size() - pos) / elementSize) return nullptr;
+                count = n;
+                const std::byte* first = in.data() + pos;
+                pos += count * elementSize;
+                return first;
+            }
+
+            [[nodiscard]] std::size_t offset() const noexcept {return pos;}
             
-            if (missingReqOpt.size() != 0) throw MissingRequiredOptionsError(missingReqOpt);
+            /**
+             * @brief ignore the bytes after size
+             * 
+             */
+            void truncate(std::size_t size) noexcept {in = in.first(size);}
+
+            private:
+            std::span<const std::byte> in;
+            std::size_t pos = 0;
+        };
+
+        /**
+         * @brief write the words of a bitset of bits bits. The words beyond the size of set are zero
+         * 
+         */
+        void writeBits(SnapshotWriter& out, const _detail::DynamicBitset& set, std::size_t bits) noexcept {
+            std::span<const std::uint64_t> blocks = set.blocks();
+            for (std::size_t w = 0; w < (bits + 63) / 64; ++w) out.value(w < blocks.size() ? blocks[w] : std::uint64_t(0));
         }
 
+        /**
+         * @brief read the words written by writeBits into set, whose size is the number of bits written
+         * 
+         */
+        bool readBits(SnapshotReader& in, _detail::DynamicBitset& set) noexcept {
+            for (std::size_t w = 0; w < set.blocks().size(); ++w) {
+                std::uint64_t word;
+                if (!in.value(word)) return false;
+                set.assignBlock(w, word);
+            }
+            return true;
+        }
+
+        /**
+         * @brief append a value to a snapshot
+         * 
+         */
+        template <typename Argument>
+        void writeValue(SnapshotWriter& out, const Argument& value) {
+            if constexpr (std::same_as<Argument, std::string> || std::same_as<Argument, std::string_view>) out.array(value.data(), value.size());
+            else if constexpr (_detail::is_number_list<Argument>) out.array(value.data(), value.size());
+            else if constexpr (std::same_as<Argument, _detail::UserValue>) {
+                // a trivially copyable value is written as its bytes, any other one as its formatted text (see ArgumentTraits)
+                if (value.hasBytes()) out.bytes(value.bytes().data(), value.bytes().size());
+                else {
+                    const std::string text = value.format();
+                    out.array(text.data(), text.size());
+                }
+            }
+            else out.value(value);
+        }
+
+        /**
+         * @brief read a value written by writeValue. std::string_view values refer to the snapshot
+         * 
+         * @return true if the value was read
+         * @return false if the snapshot is truncated or the value is not valid
+         */
+        template <typename Argument>
+        bool readValue(SnapshotReader& in, Argument& value) {
+            if constexpr (std::same_as<Argument, std::string> || std::same_as<Argument, std::string_view> || _detail::is_number_list<Argument>) {
+                using Element = typename Argument::value_type;
+                std::size_t count;
+                const std::byte* first = in.array(sizeof(Element), count);
+                if (first == nullptr) return false;
+                if constexpr (std::same_as<Argument, std::string_view>) value = std::string_view(reinterpret_cast<const char*>(first), count);
+                else {
+                    value.resize(count);
+                    if (count != 0) std::memcpy(value.data(), first, count * sizeof(Element));
+                }
+                return true;
+            }
+            else if constexpr (std::same_as<Argument, _detail::UserValue>) {
+                // the type of the value comes from the schema
+                if (value.hasBytes()) return in.bytes(value.bytes().data(), value.bytes().size());
+                std::size_t count;
+                const std::byte* first = in.array(1, count);
+                return first != nullptr && value.parse(std::string_view(reinterpret_cast<const char*>(first), count)) == std::errc();
+            }
+            else if constexpr (std::same_as<Argument, bool>) {
+                unsigned char b;
+                if (!in.value(b) || b > 1) return false;
+                value = b != 0;
+                return true;
+            }
+            else return in.value(value);
+        }
+    }
+
+    std::size_t ParseResult::snapshot(std::span<std::byte> buffer) const {
+        const std::size_t count = schema->options.size();
+        for (std::size_t i = 0; i < pending.size(); ++i) if (pending[i].data() != nullptr) _convertPending(i, std::string_view());
+
+        SnapshotWriter out(buffer);
+        out.value(snapshotMagic);
+        out.value(snapshotVersion);
+        out.value(std::uint16_t(0));  // reserved
+        out.value(schema->schemaHash());
+        out.value(static_cast<std::uint32_t>(count));
+        const std::size_t sizeOffset = out.size;
+        out.value(std::uint32_t(0));  // the size of the snapshot, written at the end
+        writeBits(out, setByUser, count);
+        writeBits(out, fromEnvironment, count);
+        writeBits(out, fromConfigFile, count);
+        for (std::size_t i = 0; i < count; ++i) {
+            std::visit([this, &out, i](const auto& o) {
+                using Argument = std::remove_cvref_t<decltype(o.arg)>;
+                // a bound option holds its value in its target; the options added after the creation of this result hold their default value
+                if (o.target != nullptr && _isOwn()) writeValue(out, *o.target);
+                else writeValue(out, i < values.size() ? std::get<Argument>(values[i]) : o.arg);
+            }, schema->options[i]);
+        }
+
+        const std::uint32_t size = static_cast<std::uint32_t>(out.size);
+        if (out.size <= buffer.size()) std::memcpy(buffer.data() + sizeOffset, &size, sizeof(size));
+        return out.size;
+    }
+
+    std::vector<std::byte> ParseResult::snapshot() const {
+        std::vector<std::byte> bytes(snapshot(std::span<std::byte>()));
+        snapshot(bytes);
+        return bytes;
+    }
+
+    ParseError ParseResult::restore(std::span<const std::byte> snapshot) {
+        reset();
+        SnapshotReader in(snapshot);
+        std::uint32_t magic, count, size;
+        std::uint16_t version, reserved;
+        std::uint64_t hash;
+        if (!in.value(magic) || magic != snapshotMagic || !in.value(version) || version != snapshotVersion || !in.value(reserved) || !in.value(hash) || !in.value(count) || !in.value(size) 
+            || size < in.offset() || size > snapshot.size()) return ParseError{ParseErrc::BAD_SNAPSHOT};
+        if (hash != schema->schemaHash() || count != values.size()) return ParseError{ParseErrc::SNAPSHOT_SCHEMA_MISMATCH};
+        in.truncate(size);
+
+        bool valid = readBits(in, setByUser) && readBits(in, fromEnvironment) && readBits(in, fromConfigFile);
+        for (std::size_t i = 0; valid && i < values.size(); ++i) {
+            valid = std::visit([this, &in, i](const auto& o) {
+                using Argument = std::remove_cvref_t<decltype(o.arg)>;
+                return readValue(in, o.target != nullptr && _isOwn() ? *o.target : std::get<Argument>(values[i]));
+            }, schema->options[i]);
+        }
+        if (!valid || in.offset() != size) {
+            reset();
+            return ParseError{ParseErrc::BAD_SNAPSHOT};
+        }
+        return ParseError();
     }
 
     std::vector<std::string> CliParser::getAllPossibleOptions() const {
-        std::vector<std::string> res(cliOptions.size());
-        // now cliOptions.size() == res.size()
-        std::vector<std::string>::iterator resIt = res.begin(), resEnd;
-        // we know that cliOptions.size() == res.size(), therefore, we can directly check optIt and ingore the check on resIt
-        for (const_option_iterator optIt = cliOptions.begin(); optIt != cliOptions.end(); ++optIt) {
-            *resIt++ = optIt->first;  // set *resIt to optIt->first and increment the resIt iterator to res
+        return std::vector<std::string>(names.begin(), names.end());
+    }
+
+    std::size_t CliParser::_helpWidth() const {
+        if (helpColumns != 0) return helpColumns;
+        std::size_t columns = 0;
+        if (const char* env = std::getenv("COLUMNS"); env != nullptr && _fromChars(std::string_view(env), columns) == std::errc() && columns != 0) return columns;
+        return 80;
+    }
+
+    namespace {
+        /**
+         * @brief LineWrapper class. It appends words to a string, moving the words that do not fit in the width to a new indented line
+         * 
+         */
+        class LineWrapper {
+            public:
+            /**
+             * @brief Construct a new LineWrapper object
+             * 
+             * @param out the output
+             * @param col the current column of out
+             * @param indent the indentation of the new lines
+             * @param width the width
+             * @param lineEmpty true if no word has been written on the current line yet (the first word is not preceded by a space)
+             */
+            LineWrapper(std::pmr::string& out, std::size_t col, std::size_t indent, std::size_t width, bool lineEmpty) : out(out), col(col), indent(indent), width(width), lineEmpty(lineEmpty) {}
+
+            /**
+             * @brief append a word. A word longer than the width is written on its own line
+             * 
+             * @param w the word
+             * @param brackets if true, the word is enclosed in square brackets
+             */
+            void word(std::string_view w, bool brackets=false) {
+                const std::size_t len = w.size() + (brackets ? 2 : 0);
+                if (!lineEmpty) {
+                    if (col + 1 + len > width) {
+                        out += '\n';
+                        out.append(indent, ' ');
+                        col = indent;
+                    }
+                    else {
+                        out += ' ';
+                        ++col;
+                    }
+                }
+                if (brackets) out += '[';
+                out += w;
+                if (brackets) out += ']';
+                col += len;
+                lineEmpty = false;
+            }
+
+            /**
+             * @brief append the words of t (separated by white spaces)
+             * 
+             * @param t the text
+             */
+            void text(std::string_view t) {
+                constexpr std::string_view spaces = " \t\n";
+                for (std::string_view::size_type begin = t.find_first_not_of(spaces); begin != std::string_view::npos; begin = t.find_first_not_of(spaces, begin)) {
+                    std::string_view::size_type end = std::min(t.find_first_of(spaces, begin), t.size());
+                    word(t.substr(begin, end - begin));
+                    begin = end;
+                }
+            }
+
+            private:
+            std::pmr::string& out;
+            std::size_t col;
+            std::size_t indent;
+            std::size_t width;
+            bool lineEmpty;
+        };
+    }
+
+    const CliParser::HelpCache& CliParser::_renderHelp() const {
+        const std::size_t width = _helpWidth();
+        if (helpCache.width == width) return helpCache;
+
+        // usage: the application name followed by the options in declaration order; the continuation lines are aligned after the name
+        std::pmr::string& usage = helpCache.usage;
+        usage.assign(appName);
+        LineWrapper usageWrapper(usage, appName.size(), std::min(appName.size() + 1, width / 2), width, appName.empty());
+        for (size_type i = 0; i < options.size(); ++i) usageWrapper.word(names[i], !requiredBits.test(i));
+        if (!subcommands.empty()) usageWrapper.word("<command> ...", true);
+        if (positional) usageWrapper.word("[--] [args...]");
+
+        // table: two columns, the names padded to the longest one (up to maxNameColumn). Longer names push their description to the next line
+        constexpr std::size_t indent = 2, gap = 2, maxNameColumn = 30;
+        std::size_t nameColumn = 0;
+        for (std::string_view name : names) {
+            if (name.size() <= maxNameColumn) nameColumn = std::max(nameColumn, name.size());
         }
-        
-        return res;
+        for (const std::unique_ptr<Subcommand>& sub : subcommands) {
+            if (sub->name.size() <= maxNameColumn) nameColumn = std::max(nameColumn, sub->name.size());
+        }
+        const std::size_t descrColumn = indent + nameColumn + gap;
+        // when the terminal is too narrow for two columns, the descriptions are not wrapped
+        const std::size_t descrWidth = width >= descrColumn + 20 ? width : static_cast<std::size_t>(-1);
+
+        std::pmr::string& table = helpCache.table;
+        table.clear();
+        auto row = [&table, nameColumn, descrColumn, descrWidth](std::string_view name, std::string_view description) {
+            table.append(indent, ' ');
+            table += name;
+            if (name.size() > nameColumn) {
+                table += '\n';
+                table.append(descrColumn, ' ');
+            }
+            else table.append(descrColumn - indent - name.size(), ' ');
+            LineWrapper(table, descrColumn, descrColumn, descrWidth, true).text(description);
+            table += '\n';
+        };
+        for (size_type i = 0; i < options.size(); ++i) row(names[i], _base(options[i]).descr);
+        // the subcommands are listed without building their CliParser
+        if (!subcommands.empty()) table += "\ncommands:\n";
+        for (const std::unique_ptr<Subcommand>& sub : subcommands) row(sub->name, sub->descr);
+
+        helpCache.width = width;
+        return helpCache;
     }
 
     std::string CliParser::help(bool full, bool includeExecutablePath, bool includeVersion) const {
-        // define some constant strings that will be used to form the help string
-        std::string helpStr = appName;
-        std::string optionHelpStr = "";
-        for (const option_dictionary::value_type& item : cliOptions) {
-            if (item.second->isOptional()) helpStr += " [" + item.first + "]";
-            else helpStr += " " + item.first;
-
-            if (full) optionHelpStr += item.first + "\t\t\t" + item.second->descr + "\n";
-        }
-        helpStr += "\n";
-        // add the version if includeVersion is true
-        if (includeVersion) helpStr += "\nversion: " + ver + "\n";
-        // add the executablePath if it exists and includeExecutablePath is true
-        if (includeExecutablePath && executablePath.size() != 0) helpStr += "\ninstalled at: " + executablePath + "\n";
-        helpStr += "\n";
-        /*
-        use std::move(optionHelpStr) when calling operator+
-        Indeed, we do not have to create a "deep" copy of the string 
-        since we return the result with a return statement
-        and we will have no use of optionHelpStr after this operation 
-        */
-        return full ? helpStr + std::move(optionHelpStr) : helpStr;
+        // the size is computed first: the string is allocated once
+        std::size_t size = 0;
+        _writeHelp([&size](std::string_view part) {size += part.size();}, full, includeExecutablePath, includeVersion);
+        std::string helpStr;
+        helpStr.reserve(size);
+        _writeHelp([&helpStr](std::string_view part) {helpStr += part;}, full, includeExecutablePath, includeVersion);
+        return helpStr;
     }
 
-    template <> bool CliParser::parseArg<bool>(const char* input) {
-        constexpr static const char* _yesStr = "y";
-        constexpr static const char* _trueStr = "true";
-        constexpr static const char* _noStr = "n";
-        constexpr static const char* _falseStr = "false";
-        constexpr static const std::string_view y(_yesStr, 1), t(_trueStr, 4), n(_noStr, 1), f(_falseStr, 5);
-        static const std::string parsingError = "invalid bool argument";
+    std::ostream& CliParser::help(std::ostream& os, bool full, bool includeExecutablePath, bool includeVersion) const {
+        _writeHelp([&os](std::string_view part) {os << part;}, full, includeExecutablePath, includeVersion);
+        return os;
+    }
+
+    std::size_t CliParser::help(std::span<char> buffer, bool full, bool includeExecutablePath, bool includeVersion) const {
+        std::size_t size = 0;
+        _writeHelp([&size, buffer](std::string_view part) {
+            if (size < buffer.size()) part.copy(buffer.data() + size, std::min(part.size(), buffer.size() - size));
+            size += part.size();
+        }, full, includeExecutablePath, includeVersion);
+        return size;
+    }
+
+    template <> std::errc CliParser::_convertArg<bool>(std::string_view input, bool& value) {
+        constexpr std::string_view y = "y", t = "true", n = "n", f = "false";
+        
+        // compare the input with a lowercase literal, converting each character of the input to lowercase on the fly
+        constexpr auto equalsIgnoreCase = [](std::string_view in, std::string_view lower) {
+            if (in.size() != lower.size()) return false;
+            for (std::string_view::size_type i = 0; i < in.size(); ++i) {
+                if (static_cast<char>(in[i] + (in[i] >= 'A' && in[i] <= 'Z')*32) != lower[i]) return false;
+            }
+            return true;
+        };
         
-        // convert the input to lowercase
-        std::string in(input);
-        for (std::string::iterator it = in.begin(); it != in.end(); ++it) {
-            *it += (*it >= 'A' && *it <='Z')*32;
-        }
         // now check the input
-        if (y == in || t == in) return true;
-        else if (n == in || f == in) return false;
-        else throw std::invalid_argument(parsingError);
+        if (equalsIgnoreCase(input, y) || equalsIgnoreCase(input, t)) value = true;
+        else if (equalsIgnoreCase(input, n) || equalsIgnoreCase(input, f)) value = false;
+        else return std::errc::invalid_argument;
+        return std::errc();
     }
 
 }
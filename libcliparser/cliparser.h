@@ -4,8 +4,8 @@
  * @version 1.0
  * @date 2021-07-17
  * 
- * The cliparser::CliParsableArgument concept determines whether a type can be safely parsed from the CLI by this library. 
- * Right now, only int, long, long long, float, double, long double, bool and std::string are allowed.
+ * The cliparser::CliParsableArgument concept determines whether a type can be safely parsed from the CLI by this library (user-defined types are added through cliparser::ArgumentTraits). 
+ * Right now, only int, long, long long, float, double, long double, bool, std::string and std::string_view are allowed.
  * 
  * cliparser::CliParser is a class that stores some app information and all the options (and their values) internally. 
  * 
@@ -17,13 +17,35 @@
 #include <iostream>
 #include <unordered_map>
 #include <string>
+#include <string_view>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <utility>
 #include <concepts>
 #include <vector>
-#include <typeinfo>
+#include <span>
+#include <variant>
 #include <type_traits>
+#include <charconv>
+#include <system_error>
+#include <stdexcept>
+#include <ostream>
+#include <cstdint>
+#include <bit>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <array>
+#include <typeinfo>
+#include <chrono>
 
 #include <libcliparser/exceptions.h>  // cliparser exceptions
+#include <libcliparser/parse_error.h>  // cliparser::ParseError, returned by CliParser::tryParse
+#include <libcliparser/mapped_file.h>  // cliparser::MappedFile, used for response files
+#include <libcliparser/stats.h>  // LIBCLIPARSER_STATS, see cliparser::ParseStats
+#include <libcliparser/constraints.h>  // ready-made constraints for cliparser::CliParser::constrain
 
 /**
  * @brief namespace that holds anything defined in the cliparser library in order to avoid potential name collisions with other libraries 
@@ -31,22 +53,99 @@
  */
 namespace cliparser {
 
+    /**
+     * @brief ArgumentTraits struct template: the customization point for user-defined argument types. 
+     * Specialise it with a static parse function to make Argument satisfy the CliParsableArgument concept:
+     * 
+     * struct Bytes {std::uint64_t count;};
+     * template <> struct cliparser::ArgumentTraits<Bytes> {
+     *     static std::errc parse(std::string_view input, Bytes& value);  // e.g. "64MiB"
+     * };
+     * parser.option("--cache", "cache size", Bytes{1 << 20});
+     * 
+     * parse must return std::errc() on success and must not throw. On failure, it returns std::errc::result_out_of_range (ParseErrc::VALUE_OUT_OF_RANGE), 
+     * std::errc::argument_out_of_domain (ParseErrc::CONSTRAINT_VIOLATION, see CliParser::constrain) or any other error code (ParseErrc::INVALID_VALUE). 
+     * Argument must be default constructible and copyable. If it is not trivially copyable (e.g. it holds a std::string), the specialisation must also have a static function 
+     * std::string format(const Argument&) whose result parse reads back into an equal value: ParseResult::snapshot stores the formatted value (a trivially copyable value is stored as its bytes). 
+     * 
+     * PLEASE NOTE that this is not a zero-overhead customization point. The set of the option types of CliParser is closed (the parse is compiled once, in the library), 
+     * therefore all the user-defined types share one alternative of the variants of the options, _detail::UserValue, which erases the type: 
+     * a value is converted through a function pointer (one indirect call, which calls ArgumentTraits<Argument>::parse), the type check of getOption compares a tag, 
+     * and a value that is not trivially copyable, or larger than _detail::user_value_capacity bytes, is allocated on the heap (its copies allocate too). 
+     * A small trivially copyable value (e.g. a duration, a byte size, an enum or an IPv4 address) is stored in place, without any allocation. 
+     * getOption returns a trivially copyable user-defined value by value, any other by const reference
+     * 
+     * @tparam Argument a user-defined type
+     */
+    template <typename Argument>
+    struct ArgumentTraits;
+
+    /**
+     * @brief namespace for implementation details of the library. Its content is not part of the public interface
+     * 
+     */
+    namespace _detail {
+        /**
+         * @brief true if List is std::vector<Number>, where Number is int, long, long long, float, double or long double: the list options (see CliParsableArgument)
+         * 
+         * @tparam List a type
+         */
+        template <typename List>
+        inline constexpr bool is_number_list = false;
+
+        template <typename Number>
+        inline constexpr bool is_number_list<std::vector<Number>> = std::same_as<Number, int> || std::same_as<Number, long> || std::same_as<Number, long long> || std::floating_point<Number>;
+
+        /**
+         * @brief BuiltinArgument concept: the argument types parsed by the library itself (see CliParsableArgument)
+         * 
+         * @tparam Argument a type
+         */
+        template <typename Argument>
+        concept BuiltinArgument = std::same_as<Argument, int> 
+            || std::same_as<Argument, long> 
+            || std::same_as<Argument, long long>
+            || std::same_as<Argument, bool>
+            || std::floating_point<Argument>
+            || std::same_as<Argument, std::string>
+            || std::same_as<Argument, std::string_view>
+            || is_number_list<Argument>;
+
+        inline constexpr std::size_t user_value_capacity = 24;  ///< the maximum size of a user-defined argument type stored in place. It keeps value_variant as large as with the built-in types only
+        inline constexpr std::size_t user_value_alignment = alignof(std::max_align_t);  ///< the maximum alignment of a user-defined argument type stored in place
+
+        /**
+         * @brief UserArgument concept: a type made parsable by a specialisation of ArgumentTraits (see ArgumentTraits for the requirements)
+         * 
+         * @tparam Argument a type
+         */
+        template <typename Argument>
+        concept UserArgument = !BuiltinArgument<Argument> 
+            && requires(std::string_view input, Argument& value) {
+                {ArgumentTraits<Argument>::parse(input, value)} -> std::same_as<std::errc>;
+            }
+            && std::copyable<Argument> && std::default_initializable<Argument>
+            && (std::is_trivially_copyable_v<Argument> || requires(const Argument& value) {
+                {ArgumentTraits<Argument>::format(value)} -> std::convertible_to<std::string>;
+            });
+    }
+
     /**
      * @brief CliParsableArgument concept. If this concept is satisfied for a given type "Argument", a variable of that type can be safely parsed by CliParser
      * 
-     * Only int, long, long long, bool, std::string, float, double, and long double satisfy this concept.
+     * Only int, long, long long, bool, std::string, std::string_view, float, double, and long double satisfy this concept, 
+     * as well as std::vector of int, long, long long, float, double and long double (list options: see CliParser::option) 
+     * and the user-defined types with a specialisation of ArgumentTraits.
+     * 
+     * A std::string_view option does not copy its value: it points into argv (or into the response file it comes from, see CliParser::enableResponseFiles). 
+     * Therefore, it is valid as long as argv (or the ParseResult) is. A std::string_view default value must refer to storage that outlives the parser, e.g. a string literal
      * 
      * PLEASE NOTE that the references are allowed in order to exploit forwarding references
      * 
      * @tparam Argument a type
      */
     template <typename Argument>
-    concept CliParsableArgument = std::same_as<Argument, int> 
-        || std::same_as<Argument, long> 
-        || std::same_as<Argument, long long>
-        || std::same_as<Argument, bool>
-        || std::floating_point<Argument>
-        || std::same_as<Argument, std::string>;
+    concept CliParsableArgument = _detail::BuiltinArgument<Argument> || _detail::UserArgument<Argument>;
     
     /**
      * @brief CliParsableArgumentOrItsReference concept. This concept is satisfied if Argument satisfies the CliParsableArgument concept or if it is a reference to a type that satisfies CliParsableArgument concept
@@ -57,145 +156,1325 @@ namespace cliparser {
     template <typename Argument>
     concept CliParsableArgumentOrItsReference = CliParsableArgument<typename std::decay<Argument>::type>;
 
-    /**
-     * @brief CliParser class. Simple CLI parsing. No positional arguments are allowed. Only one argument per option is allowed. Flags are allowed.
-     * 
-     * This class  stores some app information and all the options (and their values) internally. 
-     * Objects of this class cannot be default, copy or move constructed, or copy or move assigned. 
-     * 
-     * 
-     * Implementation details:
-     * 
-     * To achieve this result, CliParser defines an abstract base struct (OptionBase), which is publicly inherited by a template <CliParsableArgument Argument> Option class template. 
-     * This allows the CliParser class to store and access options polymorphically by using std::unordered_map<std::string, OptionBase*>
-     * 
-     */
-    class CliParser {
-        public:
+    class CliParser;  // forward declaration of the CliParser class
+
+    namespace _detail {
+        template <typename Argument> using identity = Argument;  ///< identity alias template
+
+        /**
+         * @brief UserValue class. The value of an option whose type is user-defined (see ArgumentTraits), together with the operations and the identity of its type, 
+         * which is also the type tag: all the user-defined types share one alternative of argument_variant. 
+         * A small trivially copyable value is stored in place; any other value is allocated on the heap
+         * 
+         */
+        class UserValue {
+            public:
+            using converter = std::errc (*)(std::string_view, UserValue&);  ///< type of the conversion of a user-defined type
+
+            /**
+             * @brief Construct a new UserValue object that holds no value
+             * 
+             */
+            UserValue() noexcept = default;
+
+            /**
+             * @brief Construct a new UserValue object that holds a copy of value
+             * 
+             * @tparam Argument a user-defined argument type
+             * @param value the value
+             */
+            template <UserArgument Argument>
+            explicit UserValue(const Argument& value) : type(&_typeOf<Argument>) {
+                if constexpr (_inPlace<Argument>) std::memcpy(storage, &value, sizeof(Argument));
+                else heap = new Argument(value);
+            }
+
+            /**
+             * @brief Construct a new UserValue object that holds a copy of the value of other
+             * 
+             * @param other the value to copy
+             */
+            UserValue(const UserValue& other) : type(other.type) {
+                if (type == nullptr || type->clone == nullptr) std::memcpy(storage, other.storage, sizeof(storage));
+                else heap = type->clone(other.heap);
+            }
+
+            /**
+             * @brief Construct a new UserValue object that takes the value of other. A value on the heap is not copied: other is left without a value
+             * 
+             * @param other the value to move
+             */
+            UserValue(UserValue&& other) noexcept : type(other.type) {
+                if (type == nullptr || type->clone == nullptr) std::memcpy(storage, other.storage, sizeof(storage));
+                else {
+                    heap = std::exchange(other.heap, nullptr);
+                    other.type = nullptr;
+                }
+            }
+
+            /**
+             * @brief copy the value of other into this object. If both values are on the heap and have the same type, the value is copy-assigned (e.g. a std::string member reuses its buffer)
+             * 
+             * @param other the value to copy
+             * @return UserValue& this object
+             */
+            UserValue& operator=(const UserValue& other) {
+                if (this == &other) return *this;
+                if (type == other.type && type != nullptr && type->clone != nullptr) type->assign(heap, other.heap);
+                else *this = UserValue(other);
+                return *this;
+            }
+
+            /**
+             * @brief move the value of other into this object (see UserValue(UserValue&&))
+             * 
+             * @param other the value to move
+             * @return UserValue& this object
+             */
+            UserValue& operator=(UserValue&& other) noexcept {
+                if (this == &other) return *this;
+                _destroy();
+                type = other.type;
+                if (type == nullptr || type->clone == nullptr) std::memcpy(storage, other.storage, sizeof(storage));
+                else {
+                    heap = std::exchange(other.heap, nullptr);
+                    other.type = nullptr;
+                }
+                return *this;
+            }
+
+            ~UserValue() {_destroy();}
+
+            /**
+             * @brief check whether this object holds a value of type Argument
+             * 
+             * @tparam Argument a user-defined argument type
+             * @return true if the value has type Argument
+             * @return false otherwise
+             */
+            template <UserArgument Argument>
+            [[nodiscard]] bool holds() const noexcept {return type == &_typeOf<Argument>;}
+
+            /**
+             * @brief get the value. It must have type Argument (see holds)
+             * 
+             * @tparam Argument a user-defined argument type
+             * @return const Argument& the value
+             */
+            template <UserArgument Argument>
+            [[nodiscard]] const Argument& get() const noexcept {return *static_cast<const Argument*>(_object());}
+
+            /**
+             * @brief convert input with ArgumentTraits<T>::parse, where T is the type of the value. The value is modified only if the conversion succeeds
+             * 
+             * @param input the input
+             * @return std::errc the result of ArgumentTraits<T>::parse (std::errc::invalid_argument if this object holds no value)
+             */
+            std::errc parse(std::string_view input) {return type != nullptr ? type->convert(input, *this) : std::errc::invalid_argument;}
+
+            /**
+             * @brief check whether the value is trivially copyable, i.e. whether it is snapshotted as its bytes (see bytes) rather than formatted (see format)
+             * 
+             * @return true if the type of the value is trivially copyable
+             * @return false otherwise, or if this object holds no value
+             */
+            [[nodiscard]] bool hasBytes() const noexcept {return type != nullptr && type->format == nullptr;}
+
+            /**
+             * @brief get the bytes of a trivially copyable value (see ParseResult::snapshot and hasBytes)
+             * 
+             * @return std::span<const std::byte> the bytes
+             */
+            [[nodiscard]] std::span<const std::byte> bytes() const noexcept {return {static_cast<const std::byte*>(_object()), type->size};}
+
+            /**
+             * @brief get the bytes of a trivially copyable value, to overwrite them with the bytes of a value of the same type (see ParseResult::restore and hasBytes)
+             * 
+             * @return std::span<std::byte> the bytes
+             */
+            [[nodiscard]] std::span<std::byte> bytes() noexcept {return {static_cast<std::byte*>(const_cast<void*>(_object())), type->size};}
+
+            /**
+             * @brief format a value that is not trivially copyable with ArgumentTraits<T>::format, where T is the type of the value (see ParseResult::snapshot and hasBytes). 
+             * parse reads the result back
+             * 
+             * @return std::string the formatted value
+             */
+            [[nodiscard]] std::string format() const {return type->format(heap);}
+
+            /**
+             * @brief get the name of the type of the value, as given by typeid (see CliParser::schemaHash)
+             * 
+             * @return std::string_view the name, or an empty view if this object holds no value
+             */
+            [[nodiscard]] std::string_view typeName() const noexcept {return type != nullptr ? type->name() : std::string_view();}
+
+            /**
+             * @brief get the size of the type of the value (see CliParser::schemaHash)
+             * 
+             * @return std::size_t the size, or 0 if this object holds no value
+             */
+            [[nodiscard]] std::size_t typeSize() const noexcept {return type != nullptr ? type->size : 0;}
+
+            private:
+            /**
+             * @brief the operations and the identity of a user-defined type. There is one per type: its address is the type tag. 
+             * clone, assign and destroy are nullptr for a value stored in place, format for a trivially copyable one
+             * 
+             */
+            struct Type {
+                converter convert;  ///< the conversion
+                void* (*clone)(const void*);  ///< copy a value on the heap
+                void (*assign)(void*, const void*);  ///< copy-assign a value on the heap
+                void (*destroy)(void*) noexcept;  ///< delete a value on the heap
+                std::string (*format)(const void*);  ///< format a value that is not trivially copyable
+                std::size_t size;  ///< the size of the type
+                const char* (*name)() noexcept;  ///< the name of the type, from typeid
+            };
+
+            template <UserArgument Argument>
+            static constexpr bool _inPlace = std::is_trivially_copyable_v<Argument> && sizeof(Argument) <= user_value_capacity && alignof(Argument) <= user_value_alignment;
+
+            template <UserArgument Argument>
+            static std::errc _convert(std::string_view input, UserValue& value) {
+                Argument parsed{};
+                std::errc ec = ArgumentTraits<Argument>::parse(input, parsed);
+                if (ec != std::errc()) return ec;
+                if constexpr (_inPlace<Argument>) std::memcpy(value.storage, &parsed, sizeof(Argument));
+                else *static_cast<Argument*>(value.heap) = std::move(parsed);
+                return ec;
+            }
+
+            template <UserArgument Argument>
+            static void* _clone(const void* value) {return new Argument(*static_cast<const Argument*>(value));}
+
+            template <UserArgument Argument>
+            static void _assign(void* value, const void* other) {*static_cast<Argument*>(value) = *static_cast<const Argument*>(other);}
+
+            template <UserArgument Argument>
+            static void _delete(void* value) noexcept {delete static_cast<Argument*>(value);}
+
+            template <UserArgument Argument>
+            static std::string _format(const void* value) {return ArgumentTraits<Argument>::format(*static_cast<const Argument*>(value));}
+
+            template <UserArgument Argument>
+            static const char* _name() noexcept {return typeid(Argument).name();}
+
+            template <UserArgument Argument>
+            static constexpr Type _makeType() noexcept {
+                Type t{&_convert<Argument>, nullptr, nullptr, nullptr, nullptr, sizeof(Argument), &_name<Argument>};
+                if constexpr (!_inPlace<Argument>) {
+                    t.clone = &_clone<Argument>;
+                    t.assign = &_assign<Argument>;
+                    t.destroy = &_delete<Argument>;
+                }
+                if constexpr (!std::is_trivially_copyable_v<Argument>) t.format = &_format<Argument>;
+                return t;
+            }
+
+            template <UserArgument Argument>
+            static constexpr Type _typeOf = _makeType<Argument>();
+
+            /**
+             * @brief get the address of the value: the storage or the heap
+             * 
+             */
+            [[nodiscard]] const void* _object() const noexcept {return type->clone == nullptr ? static_cast<const void*>(storage) : heap;}
+
+            void _destroy() noexcept {
+                if (type != nullptr && type->destroy != nullptr) type->destroy(heap);
+                type = nullptr;
+            }
+
+            union {
+                alignas(user_value_alignment) std::byte storage[user_value_capacity]{};  ///< the bytes of a value stored in place
+                void* heap;  ///< a value on the heap
+            };
+            const Type* type = nullptr;  ///< the type of the value, or nullptr
+        };
+
+        /**
+         * @brief StoredArgument concept: the types held by the options and the ParseResults, i.e. the built-in argument types and UserValue
+         * 
+         * @tparam Argument a type
+         */
+        template <typename Argument>
+        concept StoredArgument = BuiltinArgument<Argument> || std::same_as<Argument, UserValue>;
+
+        /**
+         * @brief the type that stores a value of type Argument: UserValue for the user-defined types, Argument itself otherwise
+         * 
+         * @tparam Argument a type that satisfies the CliParsableArgument concept
+         */
+        template <typename Argument>
+        using storage_t = std::conditional_t<UserArgument<Argument>, UserValue, Argument>;
+
+        /**
+         * @brief closed std::variant over F<Argument>, for each Argument that satisfies the StoredArgument concept. 
+         * Every variant over the arguments is defined through this alias, therefore their alternatives always have the same index
+         * 
+         * @tparam F an alias or class template
+         */
+        template <template <typename> class F>
+        using argument_variant = std::variant<F<int>, F<long>, F<long long>, F<bool>, F<float>, F<double>, F<long double>, F<std::string>, F<std::string_view>,
+            F<std::vector<int>>, F<std::vector<long>>, F<std::vector<long long>>, F<std::vector<float>>, F<std::vector<double>>, F<std::vector<long double>>, F<UserValue>>;
+
+        using value_variant = argument_variant<identity>;  ///< the value of an option, whatever its type
+
+        /**
+         * @brief StringPool class. It owns copies of strings, packed into large chunks allocated from a memory resource: the names and the descriptions of a CliParser. 
+         * Adding a string is a copy into the current chunk (a chunk allocation every few KB of text), and the strings are never moved: the views returned by intern are valid until the pool is destroyed. 
+         * Objects of this class can be moved, but not copied
+         * 
+         */
+        class StringPool {
+            public:
+            static constexpr std::size_t chunkSize = 4096;  ///< the size of a chunk. Longer strings get a chunk of their own
+
+            /**
+             * @brief Construct a new, empty StringPool object
+             * 
+             * @param resource the memory resource of the chunks
+             */
+            explicit StringPool(std::pmr::memory_resource* resource) noexcept : resource(resource) {}
+
+            StringPool(const StringPool&) = delete;
+            StringPool& operator=(const StringPool&) = delete;
+
+            /**
+             * @brief move constructor. The chunks (and the views into them) are taken over, other becomes empty
+             * 
+             * @param other the pool
+             */
+            StringPool(StringPool&& other) noexcept : resource(other.resource), head(other.head), pos(other.pos), end(other.end) {
+                other.head = nullptr;
+                other.pos = other.end = nullptr;
+            }
+
+            /**
+             * @brief move assignment. The chunks of this pool are released and those of other are taken over, together with its memory resource
+             * 
+             * @param other the pool
+             * @return StringPool& *this
+             */
+            StringPool& operator=(StringPool&& other) noexcept {
+                if (this != &other) {
+                    _release();
+                    resource = other.resource;
+                    head = std::exchange(other.head, nullptr);
+                    pos = std::exchange(other.pos, nullptr);
+                    end = std::exchange(other.end, nullptr);
+                }
+                return *this;
+            }
+
+            /**
+             * @brief Destroy the StringPool object and release its chunks
+             * 
+             */
+            ~StringPool() {_release();}
+
+            /**
+             * @brief copy text into the pool
+             * 
+             * @param text the string
+             * @return std::string_view the copy, valid as long as the pool
+             */
+            std::string_view intern(std::string_view text) {
+                if (text.empty()) return std::string_view();
+                char* dest = static_cast<std::size_t>(end - pos) >= text.size() ? std::exchange(pos, pos + text.size()) : _allocate(text.size());
+                std::memcpy(dest, text.data(), text.size());
+                return std::string_view(dest, text.size());
+            }
+
+            private:
+            struct Chunk {
+                Chunk* next;  ///< the chunk allocated before this one
+                std::size_t size;  ///< the size of the allocation, header included
+            };
+
+            /**
+             * @brief allocate size bytes in a new chunk
+             * 
+             * @param size the number of bytes
+             * @return char* the first byte
+             */
+            char* _allocate(std::size_t size);
+
+            /**
+             * @brief release all the chunks
+             * 
+             */
+            void _release() noexcept;
+
+            std::pmr::memory_resource* resource;  ///< the memory resource of the chunks
+            Chunk* head = nullptr;  ///< the last chunk allocated
+            char* pos = nullptr;  ///< the first free byte of the current chunk
+            char* end = nullptr;  ///< the end of the current chunk
+        };
+
+        /**
+         * @brief SmallIndex class. An index of the names of a small schema (up to capacity names), faster than hashing for such sizes. 
+         * Every name is summarized by a 32-bit tag, its length and its last three bytes, and the tags are packed in one cache line: 
+         * a lookup compares the tag of the key with all the tags at once (with SSE2 when available) and only the names whose tag matches are compared
+         * 
+         */
+        class SmallIndex {
+            public:
+            static constexpr std::size_t capacity = 16;  ///< the maximum number of names
+            static constexpr std::size_t npos = static_cast<std::size_t>(-1);  ///< returned by find if the key is not found
+
+            /**
+             * @brief add a name. There must be less than capacity names
+             * 
+             * @param name the name. Its index is the number of names added before it
+             */
+            void push_back(std::string_view name) noexcept {tags[count++] = _tag(name);}
+
+            /**
+             * @brief find key
+             * 
+             * @param key the name to look for
+             * @param names the names added to this index, in the same order
+             * @return std::size_t the index of key in names, or npos
+             */
+            std::size_t find(std::string_view key, const std::string_view* names) const noexcept;
+
+            /**
+             * @brief get the number of names
+             * 
+             * @return std::size_t the number of names
+             */
+            [[nodiscard]] std::size_t size() const noexcept {return count;}
+
+            private:
+            /**
+             * @brief get the tag of a name: its length (or 255, for longer names) in the low byte and its last three bytes (zero if the name is shorter) in the others
+             * 
+             * @param name the name
+             * @return std::uint32_t the tag
+             */
+            static std::uint32_t _tag(std::string_view name) noexcept {
+                std::uint32_t tag = static_cast<std::uint32_t>(std::min<std::size_t>(name.size(), 255));
+                for (std::size_t k = 0; k < 3 && k < name.size(); ++k) tag |= static_cast<std::uint32_t>(static_cast<unsigned char>(name[name.size() - 1 - k])) << (8 * (k + 1));
+                return tag;
+            }
+
+            alignas(64) std::uint32_t tags[capacity] = {};  ///< the tags of the names. The unused tags are zero
+            std::uint32_t count = 0;  ///< the number of names
+        };
+
+        /**
+         * @brief DynamicBitset class. A dense, resizable set of bits, stored in 64-bit words: a bit per option, indexed like CliParser::options. 
+         * Whole-set queries (e.g. "are all the required options set?") compare one word at a time
+         * 
+         */
+        class DynamicBitset {
+            public:
+            static constexpr std::size_t npos = static_cast<std::size_t>(-1);  ///< returned by firstMissing when no bit is missing
+
+            /**
+             * @brief Construct a new, empty DynamicBitset object
+             * 
+             * @param resource the memory resource of the words. Default: the default memory resource
+             */
+            explicit DynamicBitset(std::pmr::memory_resource* resource=std::pmr::get_default_resource()) : words(resource) {}
+
+            DynamicBitset(const DynamicBitset&) = default;
+            DynamicBitset& operator=(const DynamicBitset&) = default;
+
+            /**
+             * @brief Construct a new DynamicBitset object from another one. The other set is left empty
+             * 
+             * @param other the set to move
+             */
+            DynamicBitset(DynamicBitset&& other) noexcept : words(std::move(other.words)), bits(std::exchange(other.bits, 0)) {}
+
+            /**
+             * @brief move another set into this one. The other set is left empty (its words are cleared even if the memory resources differ)
+             * 
+             * @param other the set to move
+             * @return DynamicBitset& this set
+             */
+            DynamicBitset& operator=(DynamicBitset&& other) {
+                if (this == &other) return *this;
+                words = std::move(other.words);
+                other.words.clear();
+                bits = std::exchange(other.bits, 0);
+                return *this;
+            }
+
+            /**
+             * @brief resize the set. The new bits are cleared
+             * 
+             * @param n the number of bits
+             */
+            void resize(std::size_t n) {
+                words.resize((n + 63) / 64, 0);
+                if (n < bits && !words.empty() && n % 64 != 0) words.back() &= (std::uint64_t(1) << (n % 64)) - 1;  // keep the unused bits cleared
+                bits = n;
+            }
+
+            /**
+             * @brief get the number of bits
+             * 
+             * @return std::size_t the size
+             */
+            [[nodiscard]] std::size_t size() const noexcept {return bits;}
+
+            /**
+             * @brief test the i-th bit. Bits beyond the size are cleared
+             * 
+             * @param i the index
+             * @return true if the bit is set
+             * @return false otherwise
+             */
+            [[nodiscard]] bool test(std::size_t i) const noexcept {return i < bits && ((words[i / 64] >> (i % 64)) & 1) != 0;}
+
+            /**
+             * @brief set the i-th bit. i must be less than size()
+             * 
+             * @param i the index
+             */
+            void set(std::size_t i) noexcept {words[i / 64] |= std::uint64_t(1) << (i % 64);}
+
+            /**
+             * @brief clear the i-th bit. i must be less than size()
+             * 
+             * @param i the index
+             */
+            void reset(std::size_t i) noexcept {words[i / 64] &= ~(std::uint64_t(1) << (i % 64));}
+
+            /**
+             * @brief clear all the bits
+             * 
+             */
+            void clear() noexcept {std::fill(words.begin(), words.end(), 0);}
+
+            /**
+             * @brief get the words of the set (see ParseResult::snapshot): bit i is bit i % 64 of the word i / 64
+             * 
+             * @return std::span<const std::uint64_t> the words
+             */
+            [[nodiscard]] std::span<const std::uint64_t> blocks() const noexcept {return words;}
+
+            /**
+             * @brief overwrite the w-th word of the set (see ParseResult::restore). The bits beyond the size are cleared
+             * 
+             * @param w the index of the word. It must be less than blocks().size()
+             * @param word the bits
+             */
+            void assignBlock(std::size_t w, std::uint64_t word) noexcept {
+                if (w + 1 == words.size() && bits % 64 != 0) word &= (std::uint64_t(1) << (bits % 64)) - 1;
+                words[w] = word;
+            }
+
+            /**
+             * @brief check whether all the bits of mask are set in this set: (mask & ~*this) == 0, one word at a time
+             * 
+             * @param mask the mask
+             * @return true if every bit of mask is set
+             * @return false otherwise
+             */
+            [[nodiscard]] bool containsAll(const DynamicBitset& mask) const noexcept {return firstMissing(mask) == npos;}
+
+            /**
+             * @brief find the first bit of mask that is not set in this set
+             * 
+             * @param mask the mask
+             * @param from the first index to check. Default=0
+             * @return std::size_t the index of the bit, or npos
+             */
+            [[nodiscard]] std::size_t firstMissing(const DynamicBitset& mask, std::size_t from=0) const noexcept {
+                for (std::size_t w = from / 64; w < mask.words.size(); ++w) {
+                    std::uint64_t missing = mask.words[w] & ~(w < words.size() ? words[w] : 0);
+                    if (w == from / 64) missing &= ~std::uint64_t(0) << (from % 64);
+                    if (missing != 0) return w * 64 + static_cast<std::size_t>(std::countr_zero(missing));
+                }
+                return npos;
+            }
+
+            private:
+            std::pmr::vector<std::uint64_t> words;  ///< the bits
+            std::size_t bits = 0;  ///< the number of bits
+        };
+
+        /**
+         * @brief the return type of getOption: std::string, the lists and the user-defined types that are not trivially copyable are returned by const reference (to the value held by the ParseResult), 
+         * the other arguments by value
+         * 
+         * @tparam Argument a type that satisfies the CliParsableArgument concept
+         */
+        template <typename Argument>
+        using option_return_t = std::conditional_t<std::same_as<Argument, std::string> || is_number_list<Argument> || (UserArgument<Argument> && !std::is_trivially_copyable_v<Argument>), 
+            const Argument&, Argument>;
+
+        /**
+         * @brief the index of Argument among the alternatives of value_variant (and of every argument_variant)
+         * 
+         * @tparam Argument a type that satisfies the CliParsableArgument concept
+         */
+        template <typename Argument>
+        inline constexpr std::size_t argument_index = []<typename... Arguments>(std::variant<Arguments...>*) {
+            std::size_t i = 0;
+            (void)((std::same_as<Argument, Arguments> ? false : (++i, true)) && ...);
+            return i;
+        }(static_cast<value_variant*>(nullptr));
+
+        /**
+         * @brief check whether stored holds a value of type Argument
+         * 
+         * @tparam Argument a type that satisfies the CliParsableArgument concept
+         * @param stored the storage of the value, or nullptr
+         * @return true if stored is not nullptr and, for a user-defined type, if its value has type Argument
+         * @return false otherwise
+         */
+        template <typename Argument>
+        bool holds(const storage_t<Argument>* stored) noexcept {
+            if constexpr (UserArgument<Argument>) return stored != nullptr && stored->template holds<Argument>();
+            else return stored != nullptr;
+        }
+
+        /**
+         * @brief get the value of type Argument held by stored (see holds)
+         * 
+         * @tparam Argument a type that satisfies the CliParsableArgument concept
+         * @param stored the storage of the value
+         * @return option_return_t<Argument> the value
+         */
+        template <typename Argument>
+        option_return_t<Argument> unwrap(const storage_t<Argument>& stored) noexcept {
+            if constexpr (UserArgument<Argument>) return stored.template get<Argument>();
+            else return stored;
+        }
+
+        /**
+         * @brief TypedConstraint concept: a predicate on the values of the options of type Constraint::argument_type (see constraints.h)
+         * 
+         * @tparam Constraint a type
+         */
+        template <typename Constraint>
+        concept TypedConstraint = requires {typename Constraint::argument_type;} 
+            && CliParsableArgument<typename Constraint::argument_type> 
+            && std::predicate<const Constraint&, const typename Constraint::argument_type&>;
+    }
+
+    /**
+     * @brief OptionSource enum: where the value of an option comes from (see ParseResult::source)
+     * 
+     */
+    enum class OptionSource : unsigned char {
+        DEFAULT = 0,  ///< the option was not set by the user (also for required options that are missing)
+        CONFIG_FILE,  ///< the value was read from a configuration file (see CliParser::configFile)
+        ENVIRONMENT,  ///< the value was read from the environment variable of the option (see CliParser::env)
+        COMMAND_LINE  ///< the value was read from the command line (argv or a response file)
+    };
+
+    /**
+     * @brief ParseStats struct. What a parse did and where its time went: available through ParseResult::stats and CliParser::onParseStats, 
+     * only if the library is compiled with LIBCLIPARSER_STATS (see stats.h). The counters are reset at the beginning of each parse
+     * 
+     */
+    struct ParseStats {
+        std::size_t tokens = 0;  ///< the tokens read from argv and from the response files, values included
+        std::size_t lookups = 0;  ///< the lookups of option names in the hash tables (command line, environment, configuration files) and in the sorted index (abbreviations)
+        std::array<std::size_t, std::variant_size_v<_detail::value_variant>> conversions{};  ///< the conversions of values, per type (see conversionsOf). Lazy conversions are counted when they happen
+        std::size_t allocations = 0;  ///< the heap allocations made by the parse: the growth of std::string values and of the storage of the response files and configuration files
+        std::size_t exceptions = 0;  ///< the exceptions thrown by CliParser::parse and by ParseResult::getOption
+        std::chrono::nanoseconds schemaBuild{};  ///< the time spent adding options to the CliParser, since its construction
+        std::chrono::nanoseconds tokenization{};  ///< the time spent reading the input (argv, response files, environment, configuration files) and looking up the options, conversions excluded
+        std::chrono::nanoseconds conversion{};  ///< the time spent converting values
+        std::chrono::nanoseconds requiredCheck{};  ///< the time spent checking the required options
+
+        /**
+         * @brief get the number of conversions to Argument. The conversions of all the user-defined types (see ArgumentTraits) are counted together
+         * 
+         * @tparam Argument a type that satisfies the CliParsableArgument concept
+         * @return std::size_t the number of conversions
+         */
+        template <CliParsableArgument Argument>
+        [[nodiscard]] std::size_t conversionsOf() const noexcept {return conversions[_detail::argument_index<_detail::storage_t<Argument>>];}
+    };
+
+    /**
+     * @brief OptionHandle class. A typed reference to an option of a CliParser: it stores the position of the option, therefore reading a value through it 
+     * (CliParser::getOption(handle), ParseResult::getOption(handle)) does not hash the option name and does not check its type at run time.
+     * 
+     * A handle is obtained when the option is registered (e.g. CliParser::option(opt, description, handle)) or with CliParser::handle. 
+     * The type of the handle is the type of the option, therefore a type mismatch does not compile. A default-constructed handle is not valid
+     * 
+     * example:
+     * 
+     * cliparser::OptionHandle<int> n;
+     * parser.option<int>("-n", "integer", n);
+     * parser.parse(argc, argv);
+     * for (...) sum += parser.getOption(n);  // a plain load
+     * 
+     * @tparam Argument the type of the option
+     */
+    template <CliParsableArgument Argument>
+    class OptionHandle {
+        public:
+        using argument_type = Argument;  ///< the type of the option
+
+        /**
+         * @brief Construct a new OptionHandle object that does not refer to any option
+         * 
+         */
+        constexpr OptionHandle() noexcept = default;
+
+        /**
+         * @brief check whether this handle refers to an option
+         * 
+         * @return true if the handle was obtained from a CliParser
+         * @return false otherwise
+         */
+        [[nodiscard]] constexpr bool valid() const noexcept {return index != npos;}
+
+        private:
+        friend class CliParser;
+        friend class ParseResult;
+
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);  ///< the index of an invalid handle
+
+        constexpr explicit OptionHandle(std::size_t i) noexcept : index(i) {}
+
+        std::size_t index = npos;  ///< the position of the option in the CliParser
+    };
+
+    /**
+     * @brief ParseResult class. It holds the values of the options of a CliParser and which of them were set by the user, for one parse.
+     * 
+     * The CliParser (the schema) is never modified by CliParser::parse(argc, argv, result) and CliParser::tryParse(argc, argv, result): 
+     * any number of threads can parse against the same CliParser at the same time, as long as each thread uses its own ParseResult. 
+     * A ParseResult can be reused (see ParseResult::reset) and pooled.
+     * 
+     * The CliParser must outlive its ParseResult objects. Options added to the CliParser after the creation of a ParseResult hold their default value in it.
+     * 
+     * example:
+     * 
+     * cliparser::ParseResult res(parser);  // holds the default values
+     * parser.parse(argc, argv, res);
+     * int n = res.getOption<int>("-n");
+     * 
+     */
+    class ParseResult {
+        public:
+        /**
+         * @brief Construct a new ParseResult object that holds the default values of the options of parser
+         * 
+         * @param parser the schema
+         * @param resource the memory resource of the storage of this result, or nullptr to use the one of parser (see CliParser::get_allocator). 
+         * The values of type std::string and the lists are std::string and std::vector objects: they use the global heap. Default: nullptr
+         */
+        explicit ParseResult(const CliParser& parser, std::pmr::memory_resource* resource=nullptr);
+
+        /**
+         * @brief Get the value of the opt option. The rules and the exceptions are the same as CliParser::getOption. 
+         * With lazy conversion (see CliParser::enableLazyConversion), the first call converts the raw token and caches the value: therefore, the same ParseResult must not be read by several threads at the same time
+         * 
+         * @tparam Argument the type of the option
+         * @param opt the option
+         * @return _detail::option_return_t<Argument> the value held by the option. A std::string or a list is returned by const reference, valid until the next parse or reset of this result
+         */
+        template <CliParsableArgument Argument>
+        [[nodiscard]] _detail::option_return_t<Argument> getOption(std::string_view opt) const;
+
+        /**
+         * @brief Get the value of the option referred to by handle: a plain load, with no lookup and no check. 
+         * Unlike getOption(opt), it does not check whether a required option was set by the user: use the outcome of the parse for that. 
+         * The handle must be obtained from the CliParser of this result, and this result must have been parsed (or reset) after the option was registered. 
+         * Bound options (see CliParser::bind) are read through CliParser::getOption(handle)
+         * 
+         * @tparam Argument the type of the option
+         * @param handle the handle
+         * @return _detail::option_return_t<Argument> the value held by the option
+         */
+        template <CliParsableArgument Argument>
+        [[nodiscard]] _detail::option_return_t<Argument> getOption(OptionHandle<Argument> handle) const {
+            if (pending[handle.index].data() != nullptr) [[unlikely]] _convertPending(handle.index, std::string_view());  // lazy conversion (see CliParser::enableLazyConversion)
+            // the alternative is known to be that of Argument: the handle has the type of the option
+            return _detail::unwrap<Argument>(*std::get_if<_detail::storage_t<Argument>>(&values[handle.index]));
+        }
+
+        /**
+         * @brief this function checks whether the option identified by opt is set by the user. If option is not a valid option for the CliParser, 
+         * a NoSuchOptionException exception is thrown
+         * 
+         * @param opt the option
+         * @return true if the option was set by the user
+         * @return false otherwise
+         */
+        [[nodiscard]] bool isOptionSetByUser(std::string_view opt) const;
+
+        /**
+         * @brief get where the value of the option identified by opt comes from. If option is not a valid option for the CliParser, a NoSuchOptionException exception is thrown
+         * 
+         * @param opt the option
+         * @return OptionSource the source of the value
+         */
+        [[nodiscard]] OptionSource source(std::string_view opt) const;
+
+        /**
+         * @brief restore the default value of every option and clear which options were set by the user. The response files and the configuration files are unmapped; 
+         * nothing else is freed: the storage of the values (e.g. std::string buffers) is reused
+         * 
+         */
+        void reset();
+
+        /**
+         * @brief get the path used to invoke the program (argv[0]). It refers to the parsed argv, therefore it is valid as long as argv is
+         * 
+         * @return std::string_view the path, or an empty view if nothing was parsed
+         */
+        [[nodiscard]] std::string_view executablePath() const noexcept {return exePath;}
+
+        /**
+         * @brief get the CliParser (the schema) of this result
+         * 
+         * @return const CliParser& the schema
+         */
+        [[nodiscard]] const CliParser& parser() const noexcept {return *schema;}
+
+        /**
+         * @brief get the name of the subcommand selected by the last parse (see CliParser::subcommand)
+         * 
+         * @return std::string_view the name, or an empty view if no subcommand was given
+         */
+        [[nodiscard]] std::string_view subcommand() const noexcept;
+
+        /**
+         * @brief get the result of the subcommand selected by the last parse, i.e. the values of the options that follow the name of the subcommand. 
+         * For the result owned by a CliParser, this is the result owned by the CliParser of the subcommand
+         * 
+         * @return const ParseResult* the result, or nullptr if no subcommand was given
+         */
+        [[nodiscard]] const ParseResult* subcommandResult() const noexcept;
+
+        /**
+         * @brief get the positional arguments of the last parse into this result (see CliParser::enablePositionals), in command line order. 
+         * They refer to argv or to the response files of the parse: they are valid as long as argv is, and until the next parse or reset of this result
+         * 
+         * @return std::span<const std::string_view> the positional arguments, the remainder included
+         */
+        [[nodiscard]] std::span<const std::string_view> positionals() const noexcept {return positionalArgs;}
+
+        /**
+         * @brief get the positional arguments that follow "--" in the last parse into this result
+         * 
+         * @return std::span<const std::string_view> the remainder: the last elements of positionals(), or an empty span if there was no "--"
+         */
+        [[nodiscard]] std::span<const std::string_view> remainder() const noexcept {
+            return std::span<const std::string_view>(positionalArgs).subspan(std::min(remainderBegin, positionalArgs.size()));
+        }
+
+        /**
+         * @brief write a snapshot of this result into buffer: the values of the options and which of them were set by the user (and through which source), 
+         * in a compact binary form that ParseResult::restore loads without tokenizing or converting anything. 
+         * The snapshot starts with a magic number, a format version and the hash of the schema (see CliParser::schemaHash). 
+         * The numbers are in the byte order of the machine: a snapshot is meant for the processes started by the program (e.g. through a pipe, a memfd, shared memory or, encoded in base64 by toBase64 of base64.h, an environment variable). 
+         * The pending lazy conversions are done first: if a raw token is not valid, std::invalid_argument or std::out_of_range is thrown, like getOption. 
+         * The positional arguments, the selected subcommand, its result and the executable path are not part of the snapshot
+         * 
+         * @param buffer the output buffer
+         * @return std::size_t the size of the snapshot. If it is greater than buffer.size(), the content of buffer is unspecified
+         */
+        std::size_t snapshot(std::span<std::byte> buffer) const;
+
+        /**
+         * @brief get a snapshot of this result (see ParseResult::snapshot(std::span<std::byte>))
+         * 
+         * @return std::vector<std::byte> the snapshot
+         */
+        [[nodiscard]] std::vector<std::byte> snapshot() const;
+
+        /**
+         * @brief reset this result and load a snapshot written by ParseResult::snapshot for the same schema. 
+         * The values of type std::string_view refer to the bytes of the snapshot: like argv, they must outlive this result (or its next reset). 
+         * The required options are not checked: the snapshot holds exactly the state of the result it was written from. 
+         * If the snapshot is not valid, ParseErrc::BAD_SNAPSHOT is returned; if it was written for another schema (or by a program with different type sizes), ParseErrc::SNAPSHOT_SCHEMA_MISMATCH. 
+         * On error this result is reset, but the bound variables whose value was already loaded keep it
+         * 
+         * @param snapshot the bytes of the snapshot. Any bytes after the end of the snapshot are ignored (e.g. the padding of a mapping)
+         * @return ParseError the outcome, with code ParseErrc::OK on success
+         */
+        ParseError restore(std::span<const std::byte> snapshot);
+
+#ifdef LIBCLIPARSER_STATS
+        /**
+         * @brief get the statistics of the last parse into this result. Lazy conversions and the exceptions thrown by getOption are added when they happen. 
+         * Available only if the library is compiled with LIBCLIPARSER_STATS
+         * 
+         * @return const ParseStats& the statistics
+         */
+        [[nodiscard]] const ParseStats& stats() const noexcept {return parseStats;}
+#endif
+
+        private:
+        friend class CliParser;
+
+        /**
+         * @brief implementation of getOption(opt), for the i-th option
+         * 
+         * @tparam Argument the type of the option
+         * @param i the index of the option
+         * @param opt the option
+         * @return _detail::option_return_t<Argument> the value held by the option
+         */
+        template <CliParsableArgument Argument>
+        [[nodiscard]] _detail::option_return_t<Argument> _getOption(std::size_t i, std::string_view opt) const;
+
+        /**
+         * @brief check whether this is the ParseResult owned by the CliParser. The bound options of the CliParser (see CliParser::bind) keep their value in their target instead of in this result
+         * 
+         * @return true if this is the result used by CliParser::parse(argc, argv)
+         * @return false otherwise
+         */
+        [[nodiscard]] bool _isOwn() const noexcept;
+
+        /**
+         * @brief convert the pending raw token of the i-th option and cache the value (see CliParser::enableLazyConversion). 
+         * If the token is not valid, std::invalid_argument or std::out_of_range is thrown (with the message of the corresponding ParseError) and the token stays pending
+         * 
+         * @param i the index of the option
+         * @param opt the option, used for the error message. If empty, it is looked up
+         */
+        void _convertPending(std::size_t i, std::string_view opt) const;
+
+        /**
+         * @brief append the default value of the options that were added to the schema after the creation of this result
+         * 
+         */
+        void _sync();
+
+        const CliParser* schema;  ///< the schema
+        mutable std::pmr::vector<_detail::value_variant> values;  ///< the value of each option, indexed like CliParser::options. Mutable: lazy conversions are cached by the const getOption
+        _detail::DynamicBitset setByUser;  ///< the i-th bit is set if the i-th option was set by the user
+        _detail::DynamicBitset fromEnvironment;  ///< the i-th bit is set if the value of the i-th option was set by the user through the environment (a subset of setByUser)
+        _detail::DynamicBitset fromConfigFile;  ///< the i-th bit is set if the value of the i-th option was set by the user through a configuration file (a subset of setByUser)
+        mutable std::pmr::vector<std::string_view> pending;  ///< pending[i] is the raw token of the i-th option, not converted yet (lazy conversion), or a null view
+        std::string_view exePath;  ///< argv[0]
+        std::pmr::vector<MappedFile> mappedFiles;  ///< the response files and the configuration files read by the parse. Tokens taken from them point into these mappings
+        std::pmr::vector<std::string_view> positionalArgs;  ///< the positional arguments of the last parse. The storage is reused by the next parses
+        std::size_t remainderBegin = static_cast<std::size_t>(-1);  ///< the index in positionalArgs of the first token after "--", or -1
+        std::size_t selected = static_cast<std::size_t>(-1);  ///< the index of the selected subcommand in CliParser::subcommands, or -1
+        std::pmr::vector<ParseResult> subResult;  ///< the result of the last subcommand parsed into this result (at most one element, kept for reuse). Unused by the result owned by a CliParser
+#ifdef LIBCLIPARSER_STATS
+        mutable ParseStats parseStats;  ///< the statistics of the last parse. Mutable: the const getOption counts lazy conversions and exceptions
+#endif
+    };
+
+    /**
+     * @brief CliParser class. Simple CLI parsing. Positional arguments are collected if enabled (see CliParser::enablePositionals). Only one argument per option is allowed. Flags are allowed.
+     * 
+     * This class  stores some app information and all the options (and their values) internally. 
+     * The options (the schema) and the parsed values are kept apart: the values are stored in a ParseResult. CliParser owns one ParseResult, used by parse(argc, argv), getOption and the other functions that read the parsed values,
+     * while the const overloads parse(argc, argv, result) and tryParse(argc, argv, result) fill a ParseResult supplied by the caller without modifying the CliParser.
+     * Objects of this class cannot be default or copy constructed, or copy assigned; they can be moved (the ParseResult objects built for the moved-from CliParser are not valid anymore). 
+     * 
+     * CliParser is allocator-aware: all its storage (the options, their names and descriptions, the lookup tables, the help layout and its own ParseResult) comes from the std::pmr::memory_resource 
+     * given to the constructor, e.g. a std::pmr::monotonic_buffer_resource on the stack. The exceptions are the values of type std::string and the lists (std::string and std::vector objects), the user-defined values that are not stored in place (see ArgumentTraits), 
+     * the subcommands (see CliParser::subcommand), the statistics hook and the error path of parse (the exceptions and their messages). 
+     * CliParser::help(std::span<char>, ...) and CliParser::help(std::ostream&, ...) write the help without allocating. 
+     * A memory resource shared by concurrent parses (see CliParser::tryParseBatch) must be thread-safe (e.g. std::pmr::synchronized_pool_resource)
+     * 
+     * 
+     * Implementation details:
+     * 
+     * To achieve this result, CliParser defines a base struct (OptionBase), which is publicly inherited by a template <CliParsableArgument Argument> Option class template. 
+     * All the options are stored contiguously, in declaration order, in a std::vector of a closed std::variant over Option<Argument> (one alternative for each type that satisfies CliParsableArgument),
+     * and a std::unordered_map<std::string, size_type> maps each option to its index in the vector. The variant index is the type tag: no virtual call and no typeid comparison is needed.
+     * 
+     */
+    class CliParser {
+        public:
+        using allocator_type = std::pmr::polymorphic_allocator<>;  ///< the allocator of the storage of CliParser (see CliParser::get_allocator)
+
+        /**
+         * @brief Construct a new CliParser object
+         * 
+         * @param program the application name
+         * @param description the description of the application
+         * @param version the version. Default: "unknown"
+         * @param alloc the allocator of the storage of this CliParser (e.g. a std::pmr::memory_resource*). Default: the default memory resource
+         */
+        explicit CliParser(std::string_view program, std::string_view description, std::string_view version="unknown", const allocator_type& alloc={});
+
+        /**
+         * @brief Construct a new CliParser object, with version "unknown"
+         * 
+         * @param program the application name
+         * @param description the description of the application
+         * @param alloc the allocator of the storage of this CliParser (e.g. a std::pmr::memory_resource*)
+         */
+        CliParser(std::string_view program, std::string_view description, const allocator_type& alloc) : CliParser(program, description, "unknown", alloc) {}
+
+        /**
+         * @brief Construct a new CliParser object by moving other, including its parsed values. The memory resource is the one of other. 
+         * The ParseResult objects built for other are not valid anymore
+         * 
+         * @param other the CliParser to move
+         */
+        CliParser(CliParser&& other) noexcept;
+
+        /**
+         * @brief move other into this CliParser, including its parsed values. The memory resource of this CliParser does not change: 
+         * if it differs from the one of other, the storage is copied into it, except the names and descriptions: their pool is taken over, with the memory resource of other. 
+         * The ParseResult objects built for other or for this CliParser are not valid anymore
+         * 
+         * @param other the CliParser to move
+         * @return CliParser& *this
+         */
+        CliParser& operator=(CliParser&& other);
+
+        /**
+         * @brief get the allocator of this CliParser
+         * 
+         * @return allocator_type the allocator given to the constructor
+         */
+        [[nodiscard]] allocator_type get_allocator() const noexcept {return options.get_allocator();}
+
+        /**
+         * @brief this function adds a required option opt to this CliParser object provided it has not already been defined, otherwise it throws an OptionRedefinitionError(opt).
+         * No option should contain the character '=' or a white space. If it happens, BadOptionFormatError will be thrown
+         * 
+         * example:
+         * 
+         * CliParser parser("my app", "my descr");
+         * parser.option<std::string>("-n", "name").option<std::string>("-s", "surname").option<std::string>("-u", "username");
+         * 
+         * A list option (Argument = std::vector of a number type) takes comma-separated values and may be repeated: every occurrence appends to the list, 
+         * e.g. "-i 1 -i 2,3" or "--ids=1,2,3" (response files are the way to pass very long lists). The first occurrence from a source replaces the values of the lower-precedence sources (default, configuration files, environment). 
+         * Lists are always converted during the parse, even with CliParser::enableLazyConversion
+         * 
+         * parser.option<std::vector<long>>("-i", "ids");
+         * 
+         * 
+         * @tparam Argument type. The value held by the option will be of type Argument
+         * @param opt option
+         * @param description description
+         * @return CliParser& this object. Therefore, calls to this functions may be chained
+         */
+        template <CliParsableArgument Argument>
+        CliParser& option(std::string_view opt, std::string_view description);
+
+        /**
+         * @brief this function adds a required option opt, like CliParser::option(opt, description), and sets handle to refer to it
+         * 
+         * @tparam Argument type. The value held by the option will be of type Argument
+         * @param opt option
+         * @param description description
+         * @param handle set to the handle of the new option (see OptionHandle)
+         * @return CliParser& this object. Therefore, calls to this functions may be chained
+         */
+        template <CliParsableArgument Argument>
+        CliParser& option(std::string_view opt, std::string_view description, OptionHandle<Argument>& handle);
+
+        /**
+         * @brief this function adds an optional option opt to this CliParser object provided it has not already been defined, otherwise it throws an OptionRedefinitionError(opt). 
+         * If opt contains the character '=' or a white space, this function will throw BadOptionFormatError(opt)
+         * example:
+         * 
+         * CliParser parser("my-app", "my descr");
+         * parser.option("-n", "name", std::string("Foo")).option("-s", "name", std::string("Bar")).option("-u", "username", std::string("FooBar01")).option("--year", "year", 2021);
+         * 
+         * 
+         * @tparam Argument type that satisfies CliParsableArgumentOrItsReference concept. This type should be deduced from the function parameter "defaultValue" in order to let the code use forwarding references. The value held by the option will be of type typename std::decay<Argument>::type (which satisfies the CliParsableArgument concept). 
+         * @param opt option
+         * @param description description
+         * @param defaultValue the default Value
+         * @return CliParser& this object. Therefore, calls to this functions may be chained
+         */
+        template <CliParsableArgumentOrItsReference Argument>
+        CliParser& option(std::string_view opt, std::string_view description, Argument&& defaultValue);
+        
+
+        /**
+         * @brief this function adds an optional option opt, like CliParser::option(opt, description, defaultValue), and sets handle to refer to it
+         * 
+         * @tparam Argument type that satisfies CliParsableArgumentOrItsReference concept, deduced from defaultValue
+         * @param opt option
+         * @param description description
+         * @param defaultValue the default Value
+         * @param handle set to the handle of the new option (see OptionHandle). Its type must be the type of the option
+         * @return CliParser& this object. Therefore, calls to this functions may be chained
+         */
+        template <CliParsableArgumentOrItsReference Argument>
+        CliParser& option(std::string_view opt, std::string_view description, Argument&& defaultValue, OptionHandle<typename std::decay<Argument>::type>& handle);
+
+        /**
+         * @brief this function adds a flag to this CliParser object. A flag is a special optional (bool) option: 
+         * it does not consume any argument except itself and, when passed to the program via command line, it sets its value to true. 
+         * The default value of a flag is false.
+         * 
+         * Example: 
+         * CliParser parser("my-app", "my descr");
+         * parser.flag("-v", "version. Pass this flag to print the version");
+         * 
+         * @param opt option
+         * @param description description
+         * @return CliParser& CliParser& this object. Therefore, calls to this functions may be chained
+         */
+        CliParser& flag(std::string_view opt, std::string_view description); 
+
+        /**
+         * @brief this function adds a flag, like CliParser::flag(opt, description), and sets handle to refer to it
+         * 
+         * @param opt option
+         * @param description description
+         * @param handle set to the handle of the new flag (see OptionHandle)
+         * @return CliParser& this object. Therefore, calls to this functions may be chained
+         */
+        CliParser& flag(std::string_view opt, std::string_view description, OptionHandle<bool>& handle) {
+            flag(opt, description);
+            handle = OptionHandle<bool>(options.size() - 1);
+            return *this;
+        }
+
+        /**
+         * @brief this function adds an optional option opt bound to target, provided it has not already been defined, otherwise it throws an OptionRedefinitionError(opt). 
+         * If opt contains the character '=' or a white space, this function will throw BadOptionFormatError(opt).
+         * 
+         * CliParser::parse(argc, argv) and CliParser::tryParse(argc, argv) convert the value of the option straight into target: the parser keeps no copy of it. 
+         * If the option is not passed, target keeps its value. CliParser::reset does not modify target. 
+         * The current value of target is the default value of the option, used by the other ParseResult objects (which never write to target). 
+         * target must outlive this CliParser, or at least its last call to parse
+         * 
+         * example:
+         * 
+         * struct Config {int jobs = 4; std::string output = "a.out";} config;
+         * parser.bind("-j", config.jobs, "number of jobs").bind("-o", config.output, "output file");
+         * parser.parse(argc, argv);  // config.jobs and config.output are set directly
+         * 
+         * @tparam Argument type, deduced from target
+         * @param opt option
+         * @param target the variable the value is written to
+         * @param description description
+         * @return CliParser& this object. Therefore, calls to this functions may be chained
+         */
+        template <CliParsableArgument Argument>
+        CliParser& bind(std::string_view opt, Argument& target, std::string_view description) {
+            static_assert(!_detail::UserArgument<Argument>, "user-defined argument types cannot be bound: read them with getOption");
+            _preliminaryCheckOptionForProblems(opt);
+
+            Option<Argument> o(description, static_cast<const Argument&>(target));
+            o.target = &target;
+            _addOption(opt, std::move(o));
+
+            return *this;
+        }
+
         /**
-         * @brief user-defined destructor for the CliParser class
+         * @brief get a handle to the option opt. The option name is looked up and its type is checked only here: 
+         * if opt is not an option of this CliParser, NoSuchOptionException is thrown; if Argument is not the type of the option, BadOptionCastException is thrown
          * 
+         * @tparam Argument the type of the option
+         * @param opt the option
+         * @return OptionHandle<Argument> the handle
          */
-        ~CliParser() {
-            for (option_iterator it = cliOptions.begin(); it != cliOptions.end(); ++it) {
-                delete it->second;
-            }
+        template <CliParsableArgument Argument>
+        [[nodiscard]] OptionHandle<Argument> handle(std::string_view opt) const {
+            size_type i = _getOptionIndex(opt);
+            const Option<_detail::storage_t<Argument>>* o = std::get_if<Option<_detail::storage_t<Argument>>>(&options[i]);
+            if (!_detail::holds<Argument>(o != nullptr ? &o->arg : nullptr)) LIBCLIPARSER_THROW(BadOptionCastException(opt));
+            return OptionHandle<Argument>(i);
         }
 
         /**
-         * @brief Construct a new CliParser object
+         * @brief enable or disable the expansion of response files, as gcc and clang do: when enabled, a token @path is replaced by the tokens in the file at path. 
          * 
-         * @param program the application name
-         * @param description the description of the application
-         * @param version the version. Default: "unknown"
+         * The tokens are separated by white spaces; single quotes, double quotes and backslashes can be used to put white spaces into a token. 
+         * Response files can be nested. If the file cannot be read, the token is kept as it is. 
+         * The file is memory-mapped and tokenized in place (it is not read into a heap buffer); the mapping is owned by the ParseResult until ParseResult::reset. Default: disabled
+         * 
+         * example: 
+         * 
+         * parser.enableResponseFiles();
+         * parser.parse(argc, argv);  // e.g. ./app @args.txt -v
+         * 
+         * @param enable true to enable the expansion
+         * @return CliParser& *this
          */
-        explicit CliParser(const std::string& program, const std::string& description, const std::string& version="unknown") : appName(program), descr(description), ver(version) {}
+        CliParser& enableResponseFiles(bool enable=true) noexcept {
+            responseFiles = enable;
+            return *this;
+        }
 
         /**
-         * @brief Construct a new CliParser object
+         * @brief add a constraint to the option opt. The constraint is checked right after each conversion of a value of opt, from the command line, 
+         * the environment or a configuration file: a value that violates it is reported as ParseErrc::CONSTRAINT_VIOLATION (std::invalid_argument for parse), 
+         * and the option keeps its previous value. A list is checked as a whole, after the new values are appended: on a violation, they are removed. 
+         * The constraints of an option are checked in the order they were added. The default value is not checked. 
+         * Constrained options are converted during the parse, even with CliParser::enableLazyConversion. 
+         * If opt is not an option of this CliParser, NoSuchOptionException is thrown; if the type of the constraint is not the type of the option, BadOptionCastException is thrown
          * 
-         * @param program the application name
-         * @param description the description of the application (temporary object)
-         * @param version the version. Default: "unknown"
+         * example (see constraints.h):
+         * 
+         * parser.option("-n", "times", 1).constrain("-n", cliparser::AtLeast<1>{});
+         * parser.option<std::string>("--mode", "mode").constrain("--mode", cliparser::OneOf<std::string>{"fast", "safe"});
+         * 
+         * @tparam Constraint a predicate with a member type argument_type
+         * @param opt the option
+         * @param constraint the constraint
+         * @return CliParser& *this
          */
-        explicit CliParser(const std::string& program, std::string&& description, const std::string& version="unknown") : appName(program), descr(std::move(description)), ver(version) {}
+        template <_detail::TypedConstraint Constraint>
+        CliParser& constrain(std::string_view opt, Constraint constraint) {
+            return constrain<typename Constraint::argument_type>(opt, std::move(constraint));
+        }
 
         /**
-         * @brief this function adds a required option opt to this CliParser object provided it has not already been defined, otherwise it throws an OptionRedefinitionError(opt).
-         * No option should contain the character '=' or a white space. If it happens, BadOptionFormatError will be thrown
+         * @brief add a constraint to the option opt, like CliParser::constrain(opt, constraint), for any predicate on the type of the option
          * 
          * example:
          * 
-         * CliParser parser("my app", "my descr");
-         * parser.option<std::string>("-n", "name").option<std::string>("-s", "surname").option<std::string>("-u", "username");
+         * parser.option<int>("-j", "jobs").constrain<int>("-j", [](int j) {return j % 2 == 0;});
+         * 
+         * @tparam Argument the type of the option
+         * @tparam Predicate a predicate that takes a const Argument&
+         * @param opt the option
+         * @param predicate the constraint
+         * @return CliParser& *this
+         */
+        template <CliParsableArgument Argument, std::predicate<const Argument&> Predicate>
+        CliParser& constrain(std::string_view opt, Predicate predicate) {
+            using Stored = _detail::storage_t<Argument>;
+            Option<Stored>* o = std::get_if<Option<Stored>>(&options[_getOptionIndex(opt)]);
+            if (!_detail::holds<Argument>(o != nullptr ? &o->arg : nullptr)) LIBCLIPARSER_THROW(BadOptionCastException(opt));
+
+            std::function<bool(const Stored&)> check;
+            if constexpr (_detail::UserArgument<Argument>) check = [predicate = std::move(predicate)](const Stored& value) {return predicate(value.template get<Argument>());};
+            else check = std::move(predicate);
+            if (o->constraint) o->constraint = [first = std::move(o->constraint), second = std::move(check)](const Stored& value) {return first(value) && second(value);};
+            else o->constraint = std::move(check);
+            return *this;
+        }
+
+        /**
+         * @brief enable or disable lazy conversion. When enabled, parse and tryParse only record the raw token of each option (and that it was set by the user): 
+         * the token is converted the first time the value is read with getOption, and the value is cached. Options that are never read are never converted. 
          * 
+         * In lazy mode, an invalid value is not reported by parse/tryParse: getOption throws std::invalid_argument or std::out_of_range instead. 
+         * Bound options (see CliParser::bind), constrained options (see CliParser::constrain) and flags are always set during the parse. Default: disabled (strict mode: every value is validated by parse)
          * 
-         * @tparam Argument type. The value held by the option will be of type Argument
-         * @param opt option
-         * @param description description
-         * @return CliParser& this object. Therefore, calls to this functions may be chained
+         * @param enable true to enable lazy conversion
+         * @return CliParser& *this
          */
-        template <CliParsableArgument Argument>
-        CliParser& option(const std::string& opt, const std::string& description);
+        CliParser& enableLazyConversion(bool enable=true) noexcept {
+            lazy = enable;
+            return *this;
+        }
 
         /**
-         * @brief this function adds a required option opt to this CliParser object provided it has not already been defined, otherwise it throws an OptionRedefinitionError(opt).
-         * No option should contain the character '=' or a white space. If it happens, BadOptionFormatError will be thrown
+         * @brief read the option opt from the environment variable name when it is not passed on the command line. 
+         * parse and tryParse scan the environment once and look each variable up in a table of the declared names (getenv is never called). 
+         * A value from the environment counts as set by the user (it satisfies required options); the command line takes precedence. See ParseResult::source. 
+         * An invalid value is reported as for the command line, with ParseError::index == -1. 
+         * If opt is not an option of this CliParser, a NoSuchOptionException exception is thrown. If name is already used by another option, it is moved to opt
          * 
-         * This overload moves the description into the description of the option instead of copying the string
+         * example:
          * 
-         * @tparam Argument type. The value held by the option will be of type Argument
-         * @param opt option
-         * @param description description
-         * @return CliParser& this object. Therefore, calls to this functions may be chained
+         * parser.option("-j", "number of jobs", 4).env("-j", "APP_JOBS");
+         * 
+         * @param opt the option
+         * @param name the name of the environment variable
+         * @return CliParser& *this
          */
-        template <CliParsableArgument Argument>
-        CliParser& option(const std::string& opt, std::string&& description);
+        CliParser& env(std::string_view opt, std::string_view name) {
+            size_type i = _getOptionIndex(opt);
+            if (env_dictionary::iterator it = envNames.find(name); it != envNames.end()) it->second = i;
+            else envNames.emplace(strings.intern(name), i);
+            return *this;
+        }
 
         /**
-         * @brief this function adds an optional option opt to this CliParser object provided it has not already been defined, otherwise it throws an OptionRedefinitionError(opt). 
-         * If opt contains the character '=' or a white space, this function will throw BadOptionFormatError(opt)
+         * @brief read the options from the configuration file at path, every time parse or tryParse is called. The precedence is: configuration files < environment (see CliParser::env) < command line. 
+         * If several files are declared, the later ones take precedence: a list set by a later file replaces the values of the earlier ones (a list repeated within a file appends). 
+         * 
+         * The format is a simple INI: each line is either empty, a comment (starting with '#' or ';'), a section header "[section]" or "key = value". 
+         * The key is the name of an option without its leading dashes (e.g. "jobs = 4" sets "--jobs" or "-jobs"); inside a section, the key is "section.key". 
+         * White spaces around keys and values are ignored and a value can be enclosed in double quotes. Flags accept the same values as bool options. 
+         * 
+         * The file is memory-mapped and tokenized in one forward pass, without allocating a std::string per line: the values go through the same conversion as the command line. 
+         * Errors are reported as ParseErrc::BAD_CONFIG_FILE (the file cannot be read, or a line is not valid), ParseErrc::NO_SUCH_OPTION (unless unknown options are ignored), 
+         * ParseErrc::INVALID_VALUE or ParseErrc::VALUE_OUT_OF_RANGE. In all these cases, ParseError::index is the line number (0 if the file cannot be read)
+         * 
          * example:
          * 
-         * CliParser parser("my-app", "my descr");
-         * parser.option("-n", "name", std::string("Foo")).option("-s", "name", std::string("Bar")).option("-u", "username", std::string("FooBar01")).option("--year", "year", 2021);
+         * parser.option("--jobs", "number of jobs", 4).configFile("/etc/app.conf", false);
          * 
+         * @param path the path of the file
+         * @param required if false, a file that does not exist is skipped. Default=true
+         * @return CliParser& *this
+         */
+        CliParser& configFile(const std::string& path, bool required=true) {
+            configFiles.emplace_back(path, required);
+            return *this;
+        }
+
+        /**
+         * @brief set the environment read by parse and tryParse, instead of the one of the process (e.g. the third argument of main, or a custom block for tests). 
+         * The block is not copied: it must outlive the parses
          * 
-         * @tparam Argument type that satisfies CliParsableArgumentOrItsReference concept. This type should be deduced from the function parameter "defaultValue" in order to let the code use forwarding references. The value held by the option will be of type typename std::decay<Argument>::type (which satisfies the CliParsableArgument concept). 
-         * @param opt option
-         * @param description description
-         * @param defaultValue the default Value
-         * @return CliParser& this object. Therefore, calls to this functions may be chained
+         * @param environment a null-terminated array of "NAME=value" strings, or nullptr to read the environment of the process. Default: nullptr
+         * @return CliParser& *this
          */
-        template <CliParsableArgumentOrItsReference Argument>
-        CliParser& option(const std::string& opt, const std::string& description, Argument&& defaultValue);
-        
+        CliParser& environment(char** environment) noexcept {
+            envp = environment;
+            return *this;
+        }
+
         /**
-         * @brief this function adds an optional option opt to this CliParser object provided it has not already been defined, otherwise it throws an OptionRedefinitionError(opt). 
-         * If opt contains the character '=' or a white space, this function will throw BadOptionFormatError(opt)
-         *
-         * This overload moves the description into the description of the option instead of copying the string
+         * @brief enable or disable GNU-style abbreviations of long options: when enabled, a token that starts with "--" and is not an option 
+         * is accepted if it is the prefix of exactly one option (e.g. --verb for --verbose, also as --verb=value). 
+         * If it is the prefix of several options, parse reports ParseErrc::AMBIGUOUS_OPTION. An exact match always wins (e.g. --ver if both --ver and --verbose exist). Default: disabled
          * 
-         * @tparam Argument type that satisfies CliParsableArgumentOrItsReference concept. This type should be deduced from the function parameter "defaultValue" in order to let the code use forwarding references. The value held by the option will be of type typename std::decay<Argument>::type (which satisfies the CliParsableArgument concept). 
-         * @param opt option
-         * @param description description
-         * @param defaultValue the default Value
-         * @return CliParser& this object. Therefore, calls to this functions may be chained
+         * @param enable true to enable the abbreviations
+         * @return CliParser& *this
          */
-        template <CliParsableArgumentOrItsReference Argument>
-        CliParser& option(const std::string& opt, std::string&& description, Argument&& defaultValue);
+        CliParser& enableAbbreviations(bool enable=true) noexcept {
+            abbreviations = enable;
+            return *this;
+        }
 
         /**
-         * @brief this function adds a flag to this CliParser object. A flag is a special optional (bool) option: 
-         * it does not consume any argument except itself and, when passed to the program via command line, it sets its value to true. 
-         * The default value of a flag is false.
+         * @brief enable or disable the positional arguments: when enabled, a token that is neither an option nor a subcommand and does not start with '-' (or is "-") 
+         * is collected as a positional argument instead of being reported as ParseErrc::NO_SUCH_OPTION, and "--" ends the options: all the following tokens 
+         * (including those that start with '-' or '@') are positional arguments, the remainder. The tokens are not copied (see ParseResult::positionals). Default: disabled
          * 
-         * Example: 
-         * CliParser parser("my-app", "my descr");
-         * parser.flag("-v", "version. Pass this flag to print the version");
+         * example:
          * 
-         * @param opt option
-         * @param description description
-         * @return CliParser& CliParser& this object. Therefore, calls to this functions may be chained
+         * parser.flag("-v", "verbose").enablePositionals();
+         * parser.parse(argc, argv);  // e.g. ./app -v *.txt -- -odd-name
+         * for (std::string_view path : parser.positionals()) process(path);
+         * 
+         * @param enable true to enable the positional arguments
+         * @return CliParser& *this
          */
-        CliParser& flag(const std::string& opt, const std::string& description); 
+        CliParser& enablePositionals(bool enable=true) noexcept {
+            positional = enable;
+            helpCache.width = 0;  // the usage shows the positional arguments
+            return *this;
+        }
 
+#ifdef LIBCLIPARSER_STATS
         /**
-         * @brief this function adds a flag to this CliParser object. A flag is a special optional (bool) option: 
-         * it does not consume any argument except itself and, when passed to the program via command line, it sets its value to true. 
+         * @brief set a hook called at the end of every parse (parse, tryParse and each line of tryParseBatch, possibly from several threads at once) with the statistics of the parse. 
+         * It is called before parse throws, so ParseStats::exceptions already counts that exception. Available only if the library is compiled with LIBCLIPARSER_STATS
          * 
-         * This is an overload of CliParser::flag. This function moves the description of the flag into the Option instead of copying it
-         * 
-         * @param opt option
-         * @param description description
-         * @return CliParser& CliParser& this object. Therefore, calls to this functions may be chained
+         * @param hook the hook, or an empty function to remove it
+         * @return CliParser& *this
          */
-        CliParser& flag(const std::string& opt, std::string&& description);
+        CliParser& onParseStats(std::function<void(const ParseStats&)> hook) {
+            statsHook = std::move(hook);
+            return *this;
+        }
+#endif
 
         /**
          * @brief parse the input arguments. Here argc and argv should be the same parameters that the main function receives. argv[0] must be a string that represents the name used to invoke this program
          * 
-         * This function may throw NoSuchOptionException, MissingRequiredOption
+         * This function may throw NoSuchOptionException, MissingRequiredOptionsError, std::invalid_argument (bad value) and std::out_of_range (value out of range). See CliParser::tryParse for a non-throwing overload
          * 
          * @param argc argument counter
          * @param argv argument value 
@@ -204,25 +1483,188 @@ namespace cliparser {
          */
         void parse(int argc, char* argv[], bool ignoreUnknownOptions=false, bool suppressMissingRequiredOptionsError=false);
 
+        /**
+         * @brief parse the input arguments without throwing. The rules are the same as CliParser::parse, but the first error is returned as a ParseError (a code, the argv index and the option)
+         * instead of being thrown, and no error message is built unless ParseError::message is called. This function can be used in builds compiled without exceptions.
+         * 
+         * example:
+         * 
+         * if (cliparser::ParseError err = parser.tryParse(argc, argv)) std::cerr << err.message() << std::endl;
+         * 
+         * @param argc argument counter
+         * @param argv argument value 
+         * @param ignoreUnknownOptions if set to true, it will ignore unknown options. Otherwise, ParseErrc::NO_SUCH_OPTION is returned when an unknown option is found. Default=false
+         * @param suppressMissingRequiredOptionsError if set to true, it will not check whether any required option has been set by the user. Otherwise, ParseErrc::MISSING_REQUIRED_OPTION is returned if a required option was not provided. Default=false
+         * @return ParseError the first error found. It converts to false if the input was parsed successfully
+         */
+        [[nodiscard]] ParseError tryParse(int argc, char* argv[], bool ignoreUnknownOptions=false, bool suppressMissingRequiredOptionsError=false);
+
+        /**
+         * @brief parse the input arguments into result. The rules and the exceptions are the same as CliParser::parse(argc, argv), but this CliParser is not modified: 
+         * this function can be called by several threads at the same time, provided that each one uses its own ParseResult. Options that are not passed keep their value in result
+         * 
+         * @param argc argument counter
+         * @param argv argument value 
+         * @param result the result. It must have been created from this CliParser
+         * @param ignoreUnknownOptions if set to true, it will ignore unknown options. Default=false
+         * @param suppressMissingRequiredOptionsError if set to true, it will not check whether any required option has been set by the user. Default=false
+         */
+        void parse(int argc, char* argv[], ParseResult& result, bool ignoreUnknownOptions=false, bool suppressMissingRequiredOptionsError=false) const;
+
+        /**
+         * @brief parse the input arguments into result without throwing. The rules are the same as CliParser::tryParse(argc, argv), but this CliParser is not modified: 
+         * this function can be called by several threads at the same time, provided that each one uses its own ParseResult
+         * 
+         * @param argc argument counter
+         * @param argv argument value 
+         * @param result the result. It must have been created from this CliParser
+         * @param ignoreUnknownOptions if set to true, it will ignore unknown options. Default=false
+         * @param suppressMissingRequiredOptionsError if set to true, it will not check whether any required option has been set by the user. Default=false
+         * @return ParseError the first error found. It converts to false if the input was parsed successfully
+         */
+        [[nodiscard]] ParseError tryParse(int argc, char* argv[], ParseResult& result, bool ignoreUnknownOptions=false, bool suppressMissingRequiredOptionsError=false) const;
+
+        /**
+         * @brief parse many command lines against this CliParser, in parallel. Each command line is parsed by tryParse(argc, argv, result) into its own ParseResult; 
+         * the lines are split into small chunks that idle threads claim from a shared counter, so a thread that finishes early keeps taking work from the others.
+         * 
+         * results[i] and the i-th returned ParseError always refer to lines[i] (input order), whatever thread parsed it. 
+         * results is resized to lines.size(): existing results are reset and reused. This CliParser must not be modified while this function runs
+         * 
+         * example:
+         * 
+         * std::vector<std::vector<char*>> argvs = ...;  // each one starts with the program name
+         * std::vector<std::span<char*>> lines(argvs.begin(), argvs.end());
+         * std::vector<cliparser::ParseResult> results;
+         * std::vector<cliparser::ParseError> errors = parser.tryParseBatch(lines, results);
+         * 
+         * @param lines the command lines. Each one is an argv vector of size argc
+         * @param results the results, one for each line
+         * @param threads the number of threads. If 0, std::thread::hardware_concurrency() is used. Default=0
+         * @param ignoreUnknownOptions if set to true, it will ignore unknown options. Default=false
+         * @param suppressMissingRequiredOptionsError if set to true, it will not check whether any required option has been set by the user. Default=false
+         * @return std::vector<ParseError> the first error of each line (see tryParse), in input order
+         */
+        [[nodiscard]] std::vector<ParseError> tryParseBatch(std::span<const std::span<char*>> lines, std::vector<ParseResult>& results, unsigned int threads=0, bool ignoreUnknownOptions=false, bool suppressMissingRequiredOptionsError=false) const;
+
+        /**
+         * @brief restore every option to its default value and to its REQUIRED/OPTIONAL/FLAG state, as if CliParser::parse had never been called.
+         * Nothing is freed or rebuilt: the same CliParser object can be reused to parse any number of command lines.
+         * 
+         * example:
+         * 
+         * for (const Line& line : lines) {
+         *     parser.reset();
+         *     parser.parse(line.argc, line.argv);
+         *     // ... 
+         * }
+         * 
+         */
+        void reset() {own.reset();}
+
+        /**
+         * @brief get a snapshot of the values parsed by CliParser::parse(argc, argv), including the bound options (see ParseResult::snapshot). 
+         * A child process given the snapshot calls CliParser::restore on the same schema instead of parsing its command line again
+         * 
+         * example:
+         * 
+         * parser.parse(argc, argv);
+         * setenv("APP_SNAPSHOT", cliparser::toBase64(parser.snapshot()).c_str(), 1);  // then fork and exec the workers
+         * 
+         * @return std::vector<std::byte> the snapshot
+         */
+        [[nodiscard]] std::vector<std::byte> snapshot() const {return own.snapshot();}
+
+        /**
+         * @brief load a snapshot into the values read by getOption, instead of parsing a command line (see ParseResult::restore). 
+         * The bound options are written to their variables
+         * 
+         * example:
+         * 
+         * std::vector<std::byte> bytes;
+         * if (const char* text = std::getenv("APP_SNAPSHOT"); text == nullptr || !cliparser::fromBase64(text, bytes) || parser.restore(bytes)) parser.parse(argc, argv);
+         * 
+         * @param snapshot the bytes of the snapshot. The values of type std::string_view refer to them
+         * @return ParseError the outcome, with code ParseErrc::OK on success
+         */
+        ParseError restore(std::span<const std::byte> snapshot) {return own.restore(snapshot);}
+
+        /**
+         * @brief get the hash of the schema: the names, the types (the user-defined ones by their size and typeid name) and the REQUIRED/OPTIONAL/FLAG state of the options, in declaration order, and the sizes of the types whose size depends on the platform. 
+         * It identifies the snapshots of this schema (see CliParser::snapshot)
+         * 
+         * @return std::uint64_t the hash
+         */
+        [[nodiscard]] std::uint64_t schemaHash() const noexcept {return digest;}
+
+        /**
+         * @brief add a subcommand, git-style: "app [options] name [options of the subcommand]". The CliParser of the subcommand is built only when a parse meets name: 
+         * it is constructed with program "app name" and description, it inherits the settings of this CliParser (response files, lazy conversion, abbreviations, positional arguments, environment, help width), 
+         * then factory adds its options. Therefore, the startup cost depends on the selected subcommand only. The factory is called at most once, also by concurrent parses (see CliParser::tryParseBatch).
+         * 
+         * The options before name belong to this CliParser, the tokens after name (which is the argv[0] of the subcommand) to the subcommand. 
+         * name is recognised only as a token of argv (not in a response file) without '='. If name is already an option or a subcommand, OptionRedefinitionError is thrown
+         * 
+         * example:
+         * 
+         * parser.subcommand("commit", "record changes", [](cliparser::CliParser& commit) {commit.option<std::string>("-m", "message");});
+         * parser.parse(argc, argv);  // e.g. ./app commit -m "fix"
+         * if (parser.selectedSubcommand() == "commit") std::string m = parser.subcommandParser("commit")->getOption<std::string>("-m");
+         * 
+         * @param name the name of the subcommand
+         * @param description the description of the subcommand
+         * @param factory the function that adds the options of the subcommand
+         * @return CliParser& *this
+         */
+        CliParser& subcommand(std::string_view name, std::string_view description, std::function<void(CliParser&)> factory);
+
+        /**
+         * @brief get the name of the subcommand selected by the last CliParser::parse(argc, argv) (see ParseResult::subcommand)
+         * 
+         * @return std::string_view the name, or an empty view if no subcommand was given
+         */
+        [[nodiscard]] std::string_view selectedSubcommand() const noexcept {return own.subcommand();}
+
+        /**
+         * @brief get the CliParser of the subcommand name, if it has been built. Its own values (getOption, isOptionSetByUser, ...) are the ones parsed by CliParser::parse(argc, argv)
+         * 
+         * @param name the name of the subcommand
+         * @return const CliParser* the CliParser, or nullptr if name is not a subcommand or its CliParser has not been built yet
+         */
+        [[nodiscard]] const CliParser* subcommandParser(std::string_view name) const;
+
         /**
          * @brief Get the opt option, if it exists and is available (e.g. it is an optional option (or flag) (either default or set by the user) or a required option which has been set by the user), otherwise throw NoSuchOptionException. 
          * Furthermore, if Argument does not match the option argument type, BadOptionCastException will be thrown. 
          * If the option is required, but its value has not been parsed by CliParser::parse yet, this function will throw a BadOptionAccessException exception.
          * 
-         * @tparam Argument type. If typeid(Argument) matches that of the value held by the option, the value has type Argument
+         * @tparam Argument type. If Argument matches the type of the value held by the option (i.e. the alternative held by the std::variant), the value has type Argument
          * @param opt the option
-         * @return Argument the value held by the option
+         * @return _detail::option_return_t<Argument> the value held by the option. A std::string or a list is returned by const reference (no copy), valid until the next call to parse, tryParse or reset
          */
         template <CliParsableArgument Argument>
-        [[nodiscard]] Argument getOption(const std::string& opt) const {
-            const_option_iterator it = _getOptionIterator(opt);
+        [[nodiscard]] _detail::option_return_t<Argument> getOption(std::string_view opt) const {
+            size_type i = _getOptionIndex(opt);
+            // a bound option holds its value in its target (see CliParser::bind). User-defined types cannot be bound
+            if constexpr (!_detail::UserArgument<Argument>) {
+                if (const Option<Argument>* o = std::get_if<Option<Argument>>(&options[i]); o != nullptr && o->target != nullptr) return *o->target;
+            }
+            return own._getOption<Argument>(i, opt);
+        }
 
-            if (!it->second->good()) throw BadOptionAccessException(opt);
-            if (it->second->type() != typeid(Argument)) throw BadOptionCastException(opt);
-            // now we are certain that Argument and the type of the option are the same
-            // therefore we can use static_cast
-            // no need for typename std::decay<Argument>::type since we know that std::is_reference<Argument>::value is false (thanks to the definition of the CliParsableArgument concept)
-            return static_cast<Option<Argument>*>(it->second)->arg;
+        /**
+         * @brief Get the value of the option referred to by handle without hashing its name or checking its type (see ParseResult::getOption(handle))
+         * 
+         * @tparam Argument the type of the option
+         * @param handle a handle obtained from this CliParser
+         * @return _detail::option_return_t<Argument> the value held by the option
+         */
+        template <CliParsableArgument Argument>
+        [[nodiscard]] _detail::option_return_t<Argument> getOption(OptionHandle<Argument> handle) const {
+            if constexpr (!_detail::UserArgument<Argument>) {
+                if (const Argument* target = std::get_if<Option<Argument>>(&options[handle.index])->target; target != nullptr) return *target;
+            }
+            return own.getOption(handle);
         }
 
         /**
@@ -232,7 +1674,7 @@ namespace cliparser {
          * @return true if option is included amongst all the other options
          * @return false otherwise 
          */
-        [[nodiscard]] bool hasOption(const std::string& opt) const {return cliOptions.contains(opt);}
+        [[nodiscard]] bool hasOption(std::string_view opt) const {return _findOption(opt) != noOption;}
 
         /**
          * @brief this function checks whether the option identified by opt is optional. If option is not a valid option for this CliParser object, 
@@ -242,8 +1684,8 @@ namespace cliparser {
          * @return true if this option is optional
          * @return false otherwise
          */
-        [[nodiscard]] bool isOptionOptional(const std::string& opt) const {
-            return _getOptionIterator(opt)->second->isOptional();
+        [[nodiscard]] bool isOptionOptional(std::string_view opt) const {
+            return !requiredBits.test(_getOptionIndex(opt));
         }
 
         /**
@@ -254,23 +1696,79 @@ namespace cliparser {
          * @return true if the option was set by the user
          * @return false otherwise
          */
-        [[nodiscard]] bool isOptionSetByUser(const std::string& opt) const {
-            return _getOptionIterator(opt)->second->isSetByUser();
-        }
+        [[nodiscard]] bool isOptionSetByUser(std::string_view opt) const {return own.isOptionSetByUser(opt);}
+
+        /**
+         * @brief get where the value of the option identified by opt comes from (see ParseResult::source)
+         * 
+         * @param opt the option
+         * @return OptionSource the source of the value
+         */
+        [[nodiscard]] OptionSource source(std::string_view opt) const {return own.source(opt);}
+
+        /**
+         * @brief get the positional arguments of the last CliParser::parse(argc, argv) (see ParseResult::positionals)
+         * 
+         * @return std::span<const std::string_view> the positional arguments, in command line order
+         */
+        [[nodiscard]] std::span<const std::string_view> positionals() const noexcept {return own.positionals();}
+
+        /**
+         * @brief get the positional arguments that follow "--" in the last CliParser::parse(argc, argv) (see ParseResult::remainder)
+         * 
+         * @return std::span<const std::string_view> the remainder: the last elements of positionals()
+         */
+        [[nodiscard]] std::span<const std::string_view> remainder() const noexcept {return own.remainder();}
 
-        [[nodiscard]] bool isOptionFlag(const std::string& opt) const {
-            return _getOptionIterator(opt)->second->isFlag();
+        /**
+         * @brief this function checks whether the option identified by opt is a flag. If option is not a valid option for this CliParser object, 
+         * a NoSuchOptionException exception is thrown
+         * 
+         * @param opt the option
+         * @return true if the option is a flag
+         * @return false otherwise
+         */
+        [[nodiscard]] bool isOptionFlag(std::string_view opt) const {
+            return flagBits.test(_getOptionIndex(opt));
         }
 
         /**
          * @brief Get the a vector that holds all the possible options
          * 
-         * @return std::vector<std::string> a vector that holds all option names added to this CliParser object
+         * @return std::vector<std::string> a vector that holds all option names added to this CliParser object, in declaration order
          */
         std::vector<std::string> getAllPossibleOptions() const;
 
         /**
-         * @brief get an help string
+         * @brief get all the options without copying them
+         * 
+         * @return std::span<const std::string_view> the option names, in declaration order. They are valid as long as this CliParser is, but the span is invalidated when an option is added
+         */
+        [[nodiscard]] std::span<const std::string_view> optionNames() const noexcept {return names;}
+
+        /**
+         * @brief get the options that start with prefix (e.g. for shell completion). Nothing is allocated: the result is a range of a sorted index of the option names
+         * 
+         * example:
+         * 
+         * for (std::string_view opt : parser.complete("--ver")) std::cout << opt << '\n';  // e.g. --verbose and --version
+         * 
+         * @param prefix the prefix. An empty prefix matches all the options
+         * @return std::span<const std::string_view> the matching options, in lexicographical order. The span is invalidated when an option is added
+         */
+        [[nodiscard]] std::span<const std::string_view> complete(std::string_view prefix) const noexcept {
+            auto first = std::lower_bound(sortedNames.begin(), sortedNames.end(), prefix);
+            // all the names that start with prefix are contiguous, from the lower bound on
+            auto last = std::partition_point(first, sortedNames.end(), [prefix](std::string_view name) {return name.starts_with(prefix);});
+            return std::span<const std::string_view>(first, last);
+        }
+
+        /**
+         * @brief get an help string. 
+         * 
+         * The help lists the options in declaration order: a usage line (wrapped at the help width, see CliParser::helpWidth), the version and the executable path (if requested) and, 
+         * if full is true, a table of the options and their descriptions in aligned columns. 
+         * The layout is computed once and cached until an option is added or the width changes, therefore the cache makes this function not safe to call from several threads at the same time
          * 
          * @param full flag that determines whether this function returns a brief help string or the full help string. Default: false
          * @param includeExecutablePath flag that determines whether this function should return the path to the executable in the help string. Default: false
@@ -279,12 +1777,67 @@ namespace cliparser {
          */
         [[nodiscard]] std::string help(bool full=false, bool includeExecutablePath=false, bool includeVersion=false) const;
 
+        /**
+         * @brief write the help (see CliParser::help) to os, without building the whole string
+         * 
+         * @param os the output stream
+         * @param full flag that determines whether the brief or the full help string is written. Default: false
+         * @param includeExecutablePath flag that determines whether the path to the executable is written. Default: false
+         * @param includeVersion flag that determines whether the version is written. Default: false
+         * @return std::ostream& os
+         */
+        std::ostream& help(std::ostream& os, bool full=false, bool includeExecutablePath=false, bool includeVersion=false) const;
+
+        /**
+         * @brief write the help (see CliParser::help) into buffer, as snprintf does: the output is truncated to buffer.size() characters and no terminating null character is written. 
+         * Call it with an empty buffer to get the size to allocate
+         * 
+         * @param buffer the output buffer
+         * @param full flag that determines whether the brief or the full help string is written. Default: false
+         * @param includeExecutablePath flag that determines whether the path to the executable is written. Default: false
+         * @param includeVersion flag that determines whether the version is written. Default: false
+         * @return std::size_t the size of the whole help. If it is greater than buffer.size(), the output was truncated
+         */
+        std::size_t help(std::span<char> buffer, bool full=false, bool includeExecutablePath=false, bool includeVersion=false) const;
+
+        /**
+         * @brief set the width of the help, in columns: the usage line and the descriptions are wrapped at it. 
+         * If 0, the width is read from the COLUMNS environment variable when the help is rendered and defaults to 80. Default: 0
+         * 
+         * @param columns the width
+         * @return CliParser& *this
+         */
+        CliParser& helpWidth(std::size_t columns) noexcept {
+            helpColumns = columns;
+            return *this;
+        }
+
+        /**
+         * @brief parse input as an Argument
+         * 
+         * If input is not a valid Argument (including trailing characters, e.g. "12abc"), std::invalid_argument is thrown. If the value does not fit in an Argument, std::out_of_range is thrown
+         * 
+         * @tparam Argument the type of the argument. The new option will hold a value of type Argument. Argument satisfies the CliParsableArgument concept.
+         * @param input the input
+         * @return Argument the parsed input
+         */
+        template <CliParsableArgument Argument>
+        static Argument parseArg(std::string_view input) {
+            Argument value{};
+            std::errc ec;
+            if constexpr (_detail::UserArgument<Argument>) ec = ArgumentTraits<Argument>::parse(input, value);
+            else ec = _convertArg(input, value);
+            if (ec == std::errc::result_out_of_range) LIBCLIPARSER_THROW(std::out_of_range(std::string("\033[1;31merror: invalid input\033[0m. Value out of range: ") + std::string(input)));
+            if (ec != std::errc()) LIBCLIPARSER_THROW(std::invalid_argument(std::string("\033[1;31merror: invalid input\033[0m. Invalid value: ") + std::string(input)));
+            return value;
+        }
+
         /**
          * @brief get the application version
          * 
-         * @return const std::string& the version
+         * @return std::string_view the version
          */
-        [[nodiscard]] const std::string& version() const {return ver;}
+        [[nodiscard]] std::string_view version() const noexcept {return ver;}
         /**
          * @brief deleted default constructor
          * 
@@ -298,46 +1851,144 @@ namespace cliparser {
         CliParser(const CliParser&) = delete;
 
         /**
-         * @brief deleted move constructor
+         * @brief deleted copy assignment operator
          * 
          */
-        CliParser(CliParser&&) = delete;
+        CliParser& operator=(const CliParser&) = delete;
+
+
+        private:
+
+        friend class ParseResult;  // ParseResult reads the schema
+
+        struct OptionBase;  // forward declaration of the OptionBase struct
 
         /**
-         * @brief deleted copy assignment operator
+         * @brief convert input into value without throwing. This is the conversion used by CliParser::parseArg
+         * 
+         * The whole input must be consumed: trailing characters (e.g. "12abc") are rejected. Numbers are parsed with std::from_chars, therefore the conversion does not depend on the locale and does not allocate.
          * 
+         * @tparam Argument the type of the argument. Argument satisfies the _detail::StoredArgument concept (the user-defined types are converted through _detail::UserValue).
+         * @param input the input
+         * @param value the output. It is modified only if the conversion succeeds
+         * @return std::errc std::errc() on success, std::errc::invalid_argument if input is not a valid Argument, std::errc::result_out_of_range if the value does not fit in an Argument
          */
-        CliParser& operator=(const CliParser&) = delete;
+        template <_detail::StoredArgument Argument>
+        static std::errc _convertArg(std::string_view input, Argument& value);
 
         /**
-         * @brief deleted move assignment operator
+         * @brief convert input into value, like _convertArg, and check the result against constraint. 
+         * The input is converted into a copy of value: a value that violates the constraint does not replace the current one
          * 
+         * @tparam Argument the type of the argument. Argument satisfies the _detail::StoredArgument concept
+         * @param input the input
+         * @param value the output. It is modified only if the conversion succeeds and the constraint is satisfied
+         * @param constraint the constraint
+         * @return std::errc see _convertArg. std::errc::argument_out_of_domain if the constraint is violated
          */
-        CliParser& operator=(CliParser&&) = delete;
+        template <_detail::StoredArgument Argument>
+        static std::errc _convertConstrained(std::string_view input, Argument& value, const std::function<bool(const Argument&)>& constraint);
 
-        private:
+        /**
+         * @brief convert input into a number with std::from_chars. A leading '+' is accepted (as std::stoi and std::stod did). Leading white spaces and trailing characters are not
+         * 
+         * @tparam Number an arithmetic type other than bool
+         * @param input the input
+         * @param value the output. It is modified only if the conversion succeeds
+         * @return std::errc see _convertArg
+         */
+        template <typename Number>
+        static std::errc _fromChars(std::string_view input, Number& value) noexcept {
+            if (input.size() > 1 && input[0] == '+' && input[1] != '-') input.remove_prefix(1);
+            const char* end = input.data() + input.size();
+            Number res;
+            std::from_chars_result r;
+            if constexpr (std::floating_point<Number>) r = std::from_chars(input.data(), end, res, std::chars_format::general);
+            else r = std::from_chars(input.data(), end, res);
+
+            if (r.ec != std::errc()) return r.ec;
+            if (r.ptr != end || input.empty()) return std::errc::invalid_argument;  // full-token validation
+            value = res;
+            return std::errc();
+        }
 
-        struct OptionBase;  // forward declaration of the OptionBase struct
+        /**
+         * @brief append the comma-separated numbers of input to list. The commas are counted first (std::count, vectorised by the compiler) to reserve the whole list at once, 
+         * then each element is found with std::memchr and converted with _fromChars. An empty input appends nothing; an empty element (e.g. "1,,2") is invalid
+         * 
+         * @tparam Number an arithmetic type other than bool
+         * @param input the input
+         * @param list the output. It is modified only if the conversion of every element succeeds
+         * @return std::errc see _convertArg
+         */
+        template <typename Number>
+        static std::errc _appendList(std::string_view input, std::vector<Number>& list) {
+            if (input.empty()) return std::errc();
+            const std::size_t oldSize = list.size();
+            list.reserve(oldSize + static_cast<std::size_t>(std::count(input.begin(), input.end(), ',')) + 1);
+
+            const char* p = input.data();
+            const char* const end = p + input.size();
+            for (;;) {
+                const char* comma = static_cast<const char*>(std::memchr(p, ',', static_cast<std::size_t>(end - p)));
+                const char* elementEnd = comma != nullptr ? comma : end;
+                Number& element = list.emplace_back();
+                if (std::errc ec = _fromChars(std::string_view(p, static_cast<std::size_t>(elementEnd - p)), element); ec != std::errc()) {
+                    list.resize(oldSize);
+                    return ec;
+                }
+                if (comma == nullptr) return std::errc();
+                p = comma + 1;
+            }
+        }
 
         /**
-         * @brief parse input as an Argument
+         * @brief convert input into list, replacing its elements (see _appendList)
          * 
-         * @tparam Argument the type of the argument. The new option will hold a value of type Argument. Argument satisfies the CliParsableArgument concept.
-         * @param input the input const char*
-         * @return Argument the parsed input
+         * @tparam Number an arithmetic type other than bool
+         * @param input the input
+         * @param list the output. It is modified only if the conversion succeeds
+         * @return std::errc see _convertArg
          */
-        template <CliParsableArgument Argument>
-        static Argument parseArg(const char* input);
+        template <typename Number>
+        static std::errc _convertList(std::string_view input, std::vector<Number>& list) {
+            // the old elements are dropped only on success
+            const std::size_t oldSize = list.size();
+            std::errc ec = _appendList(input, list);
+            if (ec == std::errc()) list.erase(list.begin(), list.begin() + static_cast<std::ptrdiff_t>(oldSize));
+            return ec;
+        }
         
-        using option_dictionary = std::unordered_map<std::string, OptionBase*>;  ///< type that holds a dictionary to the options (i.e. an unordered_map that uses Key = std::string and value = OptionBase* )
+        /**
+         * @brief transparent hash for option_dictionary. Together with _OptionEqual, it allows looking up a std::string key with a std::string_view (or a string literal) without building a temporary std::string
+         *
+         */
+        struct _OptionHash {
+            using is_transparent = void;  ///< enables heterogeneous lookup
+            std::size_t operator()(std::string_view opt) const noexcept {return std::hash<std::string_view>{}(opt);}
+        };
+
+        /**
+         * @brief transparent equality for option_dictionary. The keys are compared as std::string_view, whatever the string type of the lookup
+         *
+         */
+        struct _OptionEqual {
+            using is_transparent = void;  ///< enables heterogeneous lookup
+            bool operator()(std::string_view lhs, std::string_view rhs) const noexcept {return lhs == rhs;}
+        };
+
+        using size_type = std::size_t;  ///< type of the index of an option
+        static constexpr size_type noOption = _detail::SmallIndex::npos;  ///< the index returned by CliParser::_findOption for an unknown key
+        using option_dictionary = std::pmr::unordered_map<std::string_view, size_type, _OptionHash, _OptionEqual>;  ///< type that holds a dictionary to the options (i.e. an unordered_map that uses Key = a view of a name held by CliParser::strings and value = the index of the option in CliParser::options)
+        using env_dictionary = option_dictionary;  ///< dictionary of environment variables: variable name -> index in options
         using option_iterator = typename option_dictionary::iterator;  ///< iterator from option_dictionary
         using const_option_iterator = typename option_dictionary::const_iterator;  ///< const iterator from option_dictionary
-        using size_type = typename option_dictionary::size_type;  ///< size_type from option_dictionary
         
         /**
-         * @brief OptionBase struct. OptionBase holds the base members to describe the metadata about an Option. Please note that this is an abstract class and thus cannot instantiate objects.
+         * @brief OptionBase struct. OptionBase holds the base members to describe the metadata about an Option. 
+         * info is only read when the option is registered: the state of the options is kept in dense bitsets (CliParser::requiredBits, CliParser::flagBits and ParseResult::setByUser)
          *
-         * This is the public base class of template <CliParsableArgument T> Option and will describe an interface and (when possible) its implementation. 
+         * This is the public base class of template <CliParsableArgument T> Option. It has no virtual functions: the type of an option is given by the alternative of option_variant that holds it.
          * 
          */
         struct OptionBase {
@@ -357,229 +2008,215 @@ namespace cliparser {
                 FLAG_OVERRIDEN_BY_USER = FLAG | SET_BY_USER  ///< the option was flagged as FLAG and the user overrode its default value
             };
             
-            OPTION_INFO info;  ///< information about this option
-            std::string descr;  ///< description of this option
-
-            /**
-             * @brief Destroy the OptionBase object. Virtual destructor
-             * 
-             */
-            virtual ~OptionBase()=default;
+            OPTION_INFO info;  ///< information about this option: REQUIRED, OPTIONAL or FLAG
+            std::string_view descr;  ///< description of this option, held by CliParser::strings
 
             /**
              * @brief Construct a new OptionBase object
              * 
-             * @param str the description of the option
-             * @param i information about the option
-             */
-            explicit OptionBase(const std::string& str, OPTION_INFO i) : descr(str), info(i) {}
-
-            /**
-             * @brief Construct a new OptionBase object. This moves str
-             * 
-             * @param str the description of the option
+             * @param str the description of the option. It is not copied
              * @param i information about the option
              */
-            explicit OptionBase(std::string&& str, OPTION_INFO i) : descr(std::move(str)), info(i) {}
-
-            /**
-             * @brief this function determines whether an option is "good" for use or not by casting the result of the bitwise and of info and OPTIONAL_OVERRIDEN_BY_USER to bool. 
-             * In practice good() may return false only if info is REQUIRED or BAD_OPTION. 
-             * Since BAD_OPTION is never set and only defined to define the goodness of an option, good() returns false only if info == REQUIRED, 
-             * although the implementation still calculates info & OPTIONAL_OVERRIDEN_BY_USER
-             *
-             * NOTE: OPTIONAL_OVERRIDEN_BY_USER is defined as OPTIONAL | SET_BY_USER, which means that:
-             * - if info IS REQUIRED but the user did not set it via command line, we have REQUIRED & (OPTIONAL | SET_BY_USER) = 0x01 & 0x0a = 0x00 == BAD_OPTION. Since BAD_OPTION is 0, it is treated as false when cast to bool 
-             * - if info is REQUIRED_PROVIDED_BY_USER, we have (REQUIRED | SET_BY_USER) & (OPTIONAL | SET_BY_USER) = SET_BY_USER != BAD_OPTION. Hence, since SET_BY_USER is not 0, it is true
-             * - if info is either OPTIONAL or OPTIONAL_OVERRIDEN_BY_USER, we have either OPTIONAL or OPTIONAL_OVERRIDEN_BY_USER. Neither is 0. Therefore, this is always true.
-             * 
-             *
-             * This function is marked as virtual and final: no derived class can override it.
-             *
-             * @return true if the option can be used (e.g. it is OPTIONAL, REQUIRED_PROVIDED_BY_USER, or OPTIONAL_OVERRIDEN_BY_USER)
-             * @return false otherwise
-             */
-            virtual bool good() const final {return static_cast<bool>(info & OPTIONAL_OVERRIDEN_BY_USER);}
-
-            /**
-             * @brief this function checks whether an option is optional
-             *
-             * NOTE: Virtual and final function. This function cannot be overriden.
-             * 
-             * @return true if this option is optional
-             * @return false otherwise
-             */
-            virtual bool isOptional() const final {return static_cast<bool>(info & OPTIONAL);}
-
-            /**
-             * @brief this function checks whether an option has been set by the user. 
-             * 
-             * NOTE: Virtual and final function. This function cannot be overriden.
-             * 
-             * @return true if this option has been set by the user
-             * @return false otherwise
-             */
-            virtual bool isSetByUser() const final {return static_cast<bool>(info & SET_BY_USER);}
-
-            /**
-             * @brief this function checks whether an option is a flag (i.e. bool result of info & (FLAG ^ OPTIONAL)). 
-             * 
-             * 
-             * Explanation: 
-             * FLAG ^ OPTIONAL removes OPTIONAL from FLAG
-             * info & (FLAG ^ OPTIONAL) considers only FLAGs and not OPTIONAL values 
-             * 
-             * NOTE that the XOR is fundamental since a simple info & FLAG would return true if info were OPTIONAL or OPTIONAL_SET_BY_USER, which is not the correct behaviour
-             * 
-             * NOTE: Virtual and final function. This function cannot be overriden.
-             * 
-             * @return true if this option is a flag
-             * @return false otherwise
-             */
-            virtual bool isFlag() const final {return static_cast<bool>(info & (FLAG ^ OPTIONAL));}
-
-            /**
-             * @brief Get the typeid of the option held by the Option class. This function is pointless in OptionBase and it is marked as a pure virtual function. It must be implemented by the derived classes/structs that need to instantiate objects.
-             * 
-             * @return const std::type_info& the type id of the option (see Option<T>::type)
-             */
-            virtual const std::type_info& type() const = 0;
-
-            /**
-             * @brief set the value of the option from the input. Pure virtual function of OptionBase, since the value is stored in Option, its derived struct.
-             * 
-             * @param input string literal obtained from the command line argv
-             */
-            virtual void setArgFromInput(const char* input) = 0;
+            explicit OptionBase(std::string_view str, OPTION_INFO i) noexcept : info(i), descr(str) {}
         };
 
         /**
-         * @brief Derived from OptionBase, the Option struct contains all the member of its base struct and the argument value associated to the option. 
+         * @brief Derived from OptionBase, the Option struct contains all the member of its base struct and the default value associated to the option. 
          * 
          * This struct cannot have any children as it is marked as final.
          * 
-         * @tparam Argument any type that satisfies the CliParsableArgument concept
+         * @tparam Argument any type that satisfies the _detail::StoredArgument concept (_detail::UserValue for the user-defined types)
          */
-        template <CliParsableArgument Argument> struct Option final : public OptionBase {
+        template <_detail::StoredArgument Argument> struct Option final : public OptionBase {
 
-            Argument arg;  ///< the value associated to this option. std::optional<Argument> was not used because we can already establish whether the option is required, optional and set by the user
+            Argument arg;  ///< the default value of this option (a value-initialised Argument for REQUIRED options). The parsed values are stored in a ParseResult. std::optional<Argument> was not used because we can already establish whether the option is required or optional
+            Argument* target = nullptr;  ///< the variable bound to this option (see CliParser::bind), or nullptr. CliParser::parse(argc, argv) converts the value straight into it
+            std::function<bool(const Argument&)> constraint;  ///< the constraints of this option (see CliParser::constrain), or an empty function
             
             /**
              * @brief Construct a new REQUIRED option
              * 
-             * @param descr the option description
-             */
-            explicit Option(const std::string& descr) : OptionBase(descr, REQUIRED) {}
-
-            /**
-             * @brief Construct a new REQUIRED option. This overload moves descr 
-             * 
-             * @param descr the option description
+             * @param descr the option description, held by CliParser::strings
              */
-            explicit Option(std::string&& descr) : OptionBase(std::move(descr), REQUIRED) {}
+            explicit Option(std::string_view descr) : OptionBase(descr, REQUIRED), arg() {}
 
             /**
              * @brief Construct a new OPTIONAL option with a given defaultValue by copying defaultValue into arg
              * 
-             * @param descr the description of the option
-             * @param defaultValue the default value
-             */
-            explicit Option(const std::string& descr, const Argument& defaultValue) : OptionBase(descr, OPTIONAL), arg(defaultValue) {}
-            /**
-             * @brief Construct a new OPTIONAL option with a given defaultValue by copying defaultValue into arg. This overload moves descr
-             * 
-             * @param descr the description of the option
+             * @param descr the description of the option, held by CliParser::strings
              * @param defaultValue the default value
              */
-            explicit Option(std::string&& descr, const Argument& defaultValue) : OptionBase(std::move(descr), OPTIONAL), arg(defaultValue) {}
+            Option(std::string_view descr, const Argument& defaultValue) : OptionBase(descr, OPTIONAL), arg(defaultValue) {}
 
             /**
              * @brief Construct a new OPTIONAL object with a given defaultValue by moving defaultValue into arg
              * 
-             * @param descr the description of the option
-             * @param defaultValue the default value
-             */
-            explicit Option(const std::string& descr, Argument&& defaultValue) : OptionBase(descr, OPTIONAL), arg(std::move(defaultValue)) {}
-
-            /**
-             * @brief Construct a new OPTIONAL object with a given defaultValue by moving defaultValue into arg and descr into the description of this option
-             * 
-             * @param descr the description of the option
+             * @param descr the description of the option, held by CliParser::strings
              * @param defaultValue the default value
              */
-            explicit Option(std::string&& descr, Argument&& defaultValue) : OptionBase(descr, OPTIONAL), arg(std::move(defaultValue)) {}
+            Option(std::string_view descr, Argument&& defaultValue) : OptionBase(descr, OPTIONAL), arg(std::move(defaultValue)) {}
             
             /**
              * @brief Construct a new Option<bool> with a given defaultValue. This option is either OPTIONAL or FLAG, depending on the value of isAFlag
              * 
-             * @param descr description
-             * @param defaultValue default value
-             * @param isAFlag if true, this option is a special optional option: it is a FLAG. Otherwise, it is OPTIONAL 
-             * @tparam T default=Argument. Requires std::same_as<T, Argument> && std::same_as<Argument, bool>
-             */
-            // template <typename T = Argument, typename = typename std::enable_if<std::is_same<T, Argument>::value && std::is_same<Argument, bool>::value>::type>  
-            template <typename T = Argument> requires std::same_as<T, Argument> && std::same_as<Argument, bool> // c++ 20
-            explicit Option(const std::string& descr, T defaultValue, bool isAFlag) : OptionBase(descr, OPTIONAL), arg(defaultValue) {
-                if (isAFlag) info = FLAG;
-            }
-            /**
-             * @brief Construct a new Option<bool> with a given defaultValue. This option is either OPTIONAL or FLAG, depending on the value of isAFlag. This overload moves the description descr instead of copying it
-             * 
-             * @param descr description
+             * @param descr description, held by CliParser::strings
              * @param defaultValue default value
              * @param isAFlag if true, this option is a special optional option: it is a FLAG. Otherwise, it is OPTIONAL 
              * @tparam T default=Argument. Requires std::same_as<T, Argument> && std::same_as<Argument, bool>
              */
             template <typename T = Argument> requires std::same_as<T, Argument> && std::same_as<Argument, bool> // c++ 20
-            explicit Option(std::string&& descr, T defaultValue, bool isAFlag) : OptionBase(std::move(descr), OPTIONAL), arg(defaultValue) {
+            Option(std::string_view descr, T defaultValue, bool isAFlag) : OptionBase(descr, OPTIONAL), arg(defaultValue) {
                 if (isAFlag) info = FLAG;
             }
+        };
 
+        /**
+         * @brief closed std::variant over all the Option<Argument> such that Argument satisfies the _detail::StoredArgument concept. The index of the variant is the type tag of the option
+         * 
+         */
+        using option_variant = _detail::argument_variant<Option>;
 
-            /**
-             * @brief return typeid(Argument), where Argument is the type of the value "arg" stored in this option object
-             * 
-             * @return const std::type_info& typeid(Argument)
-             */
-            const std::type_info& type() const final override {return typeid(Argument);}
+        /**
+         * @brief get the OptionBase part of an option, whatever its type
+         * 
+         * @param o the option
+         * @return const OptionBase& the base of the option
+         */
+        static const OptionBase& _base(const option_variant& o) {
+            return std::visit([](const auto& typed) -> const OptionBase& {return typed;}, o);
+        }
+
+        /**
+         * @brief get the OptionBase part of an option, whatever its type
+         * 
+         * non-const overload
+         * 
+         * @param o the option
+         * @return OptionBase& the base of the option
+         */
+        static OptionBase& _base(option_variant& o) {
+            return std::visit([](auto& typed) -> OptionBase& {return typed;}, o);
+        }
+
+        /**
+         * @brief get the index in CliParser::options of the option whose key is opt. If opt is not a key of the dictionary, throw NoSuchOptionException.
+         * 
+         * @param opt the option key
+         * @return size_type the index of the option
+         */
+        size_type _getOptionIndex(std::string_view opt) const {
+            size_type i = _findOption(opt);
+            if (i == noOption) LIBCLIPARSER_THROW(NoSuchOptionException(opt));
+            return i;
+        }
+
+        /**
+         * @brief find the option whose key is opt. Small schemas are searched with smallIndex, the others with cliOptions
+         * 
+         * @param opt the option key
+         * @return size_type the index of the option in CliParser::options, or noOption if opt is not a key
+         */
+        size_type _findOption(std::string_view opt) const noexcept {
+            if (names.size() <= _detail::SmallIndex::capacity) return smallIndex.find(opt, names.data());
+            const_option_iterator it = cliOptions.find(opt);
+            return it != cliOptions.end() ? it->second : noOption;
+        }
 
+        /**
+         * @brief add an option to this CliParser object. The option must have been checked by _preliminaryCheckOptionForProblems
+         * 
+         * @tparam Argument the type of the option
+         * @param opt the option key. It is copied into CliParser::strings
+         * @param o the option. Its description is copied into CliParser::strings
+         */
+        template <_detail::StoredArgument Argument>
+        void _addOption(std::string_view opt, Option<Argument>&& o) {
+            LIBCLIPARSER_STATS_ONLY(_detail::PhaseTimer timer(schemaBuildTime);)
+            const OptionBase::OPTION_INFO info = o.info;
+            o.descr = strings.intern(o.descr);
+            options.emplace_back(std::in_place_type<Option<Argument>>, std::move(o));
+            // the name is copied once, into the pool: the keys of the dictionaries and the sorted index are views of it
+            names.emplace_back(strings.intern(opt));
+            if (names.size() <= _detail::SmallIndex::capacity) smallIndex.push_back(names.back());
+            else if (cliOptions.empty()) {
+                // the schema outgrows the small index: from now on, the options are hashed
+                cliOptions.reserve(names.size());
+                for (size_type k = 0; k < names.size(); ++k) cliOptions.emplace(names[k], k);
+            }
+            else cliOptions.emplace(names.back(), options.size() - 1);
+            // if two options differ only in the dashes (e.g. -n and --n), the key of the configuration files refers to the first one
+            configNames.emplace(names.back().substr(std::min(names.back().find_first_not_of('-'), names.back().size())), options.size() - 1);
+            // keep the sorted index sorted: one insertion per option
+            auto pos = std::lower_bound(sortedNames.begin(), sortedNames.end(), names.back());
+            sortedIndices.insert(sortedIndices.begin() + (pos - sortedNames.begin()), options.size() - 1);
+            sortedNames.insert(pos, names.back());
+            requiredBits.resize(options.size());
+            flagBits.resize(options.size());
+            if (info == OptionBase::REQUIRED) requiredBits.set(options.size() - 1);
+            else if (info == OptionBase::FLAG) flagBits.set(options.size() - 1);
+            _hashLastOption();
+            own._sync();
+            helpCache.width = 0;  // the schema changed
+        }
+
+        /**
+         * @brief the help layout that depends only on the schema and on the width (see CliParser::help)
+         * 
+         */
+        struct HelpCache {
             /**
-             * @brief set arg to the result of the parsing of the input string literal
-             * 
-             * Example: Argument = double and input = "3.1415". arg = 3.1415
+             * @brief Construct a new, empty HelpCache object
              * 
-             * @param input input obtained from the command line argv
+             * @param alloc the allocator of the strings
              */
-            void setArgFromInput(const char* input) final override {
-                arg = parseArg<Argument>(input);
-                info = static_cast<OPTION_INFO>(info | SET_BY_USER);
-            }
+            explicit HelpCache(const allocator_type& alloc) : usage(alloc), table(alloc) {}
+
+            std::size_t width = 0;  ///< the width used to render the cache, or 0 if the cache must be rendered again
+            std::pmr::string usage;  ///< the usage line(s), without the trailing new line
+            std::pmr::string table;  ///< the table of the options
         };
 
         /**
-         * @brief get the iterator of the option_dictionary (aka std::unordered_map<std::string, OptionBase*>) to the option whose key is opt. If opt is not a key of the dictionary, throw NoSuchOptionException.
+         * @brief get the width of the help (see CliParser::helpWidth)
          * 
-         * @param opt the option key
-         * @return const_option_iterator the const iterator to the option
+         * @return std::size_t the width, in columns
          */
-        const_option_iterator _getOptionIterator(const std::string& opt) const {
-            const_option_iterator it = cliOptions.find(opt);
-            if (it == cliOptions.end()) throw NoSuchOptionException(opt);
-            return it;
-        }
+        std::size_t _helpWidth() const;
 
         /**
-         * @brief get the iterator of the option_dictionary (aka std::unordered_map<std::string, OptionBase*>) to the option whose key is opt. If opt is not a key of the dictionary, throw NoSuchOptionException.
+         * @brief render the help layout, if the cache is not valid for the current width
          * 
-         * non-const overload
+         * @return const HelpCache& the cache
+         */
+        const HelpCache& _renderHelp() const;
+
+        /**
+         * @brief call write for each part of the help, in order. Therefore, the help is produced without building a temporary string
          * 
-         * @param opt the option key
-         * @return option_iterator the const iterator to the option
+         * @tparam Writer a callable that takes a std::string_view
+         * @param write the writer
+         * @param full see CliParser::help
+         * @param includeExecutablePath see CliParser::help
+         * @param includeVersion see CliParser::help
          */
-        option_iterator _getOptionIterator(const std::string& opt) {
-            option_iterator it = cliOptions.find(opt);
-            if (it == cliOptions.end()) throw NoSuchOptionException(opt);
-            return it;
+        template <typename Writer>
+        void _writeHelp(Writer&& write, bool full, bool includeExecutablePath, bool includeVersion) const {
+            const HelpCache& cache = _renderHelp();
+            write(cache.usage);
+            write("\n");
+            if (includeVersion) {
+                write("\nversion: ");
+                write(ver);
+                write("\n");
+            }
+            // add the executablePath if it exists and includeExecutablePath is true
+            if (includeExecutablePath && !own.exePath.empty()) {
+                write("\ninstalled at: ");
+                write(own.exePath);
+                write("\n");
+            }
+            write("\n");
+            if (full) write(cache.table);
         }
         
         /**
@@ -591,13 +2228,127 @@ namespace cliparser {
          * 
          * @param opt the option string
          */
-        void _preliminaryCheckOptionForProblems(const std::string& opt) const;
+        void _preliminaryCheckOptionForProblems(std::string_view opt) const;
+
+        /**
+         * @brief add the last option added by _addOption to CliParser::digest
+         * 
+         */
+        void _hashLastOption() noexcept;
+
+        /**
+         * @brief get all the required options that have not been set by the user
+         * 
+         * @param result the result
+         * @return std::vector<std::string> the missing required options
+         */
+        std::vector<std::string> _missingRequiredOptions(const ParseResult& result) const;
+
+        /**
+         * @brief convert input into the value of the optIndex-th option in result (or into its target, or keep it pending: see CliParser::bind and CliParser::enableLazyConversion)
+         * 
+         * @param result the result
+         * @param optIndex the index of the option
+         * @param input the input
+         * @param source where input comes from: a list option appends to the values that come from the same source, and replaces the others
+         * @return std::errc the result of the conversion (see CliParser::_convertArg)
+         */
+        std::errc _assign(ParseResult& result, size_type optIndex, std::string_view input, OptionSource source) const;
+
+        /**
+         * @brief read the configuration file at path into result (see CliParser::configFile)
+         * 
+         * @param path the path of the file
+         * @param required if false, a file that does not exist is skipped
+         * @param result the result. It owns the mapping of the file
+         * @param ignoreUnknownOptions if true, unknown keys are skipped
+         * @return ParseError the first error found
+         */
+        ParseError _readConfigFile(const std::pmr::string& path, bool required, ParseResult& result, bool ignoreUnknownOptions) const;
+
+        /**
+         * @brief implementation of tryParse(argc, argv, result). With LIBCLIPARSER_STATS, parse and tryParse call it through _tryParseWithStats
+         * 
+         * @param argc argument counter
+         * @param argv argument value
+         * @param result the result
+         * @param ignoreUnknownOptions flag that determines whether unknown options are ignored
+         * @param suppressMissingRequiredOptionsError flag that determines whether missing required options are ignored
+         * @return ParseError the first error found
+         */
+        ParseError _tryParse(int argc, char* argv[], ParseResult& result, bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError) const;
+
+        /**
+         * @brief a subcommand (see CliParser::subcommand). Subcommands are stored through std::unique_ptr: a std::once_flag cannot be moved
+         * 
+         */
+        struct Subcommand {
+            std::string_view name;  ///< the name, held by CliParser::strings
+            std::string_view descr;  ///< the description, held by CliParser::strings
+            std::function<void(CliParser&)> factory;  ///< the function that adds the options to parser
+            std::once_flag built;  ///< the parser is built once, by the first parse that needs it
+            std::unique_ptr<CliParser> parser;  ///< the CliParser of the subcommand, or nullptr if not built yet
+        };
+
+        /**
+         * @brief build (once) the CliParser of the sub-th subcommand and parse the rest of the command line into it
+         * 
+         * @param sub the index of the subcommand
+         * @param argc argument counter of the subcommand
+         * @param argv argument value of the subcommand: argv[0] is the name of the subcommand
+         * @param offset the index of argv[0] in the whole command line: it is added to the index of the error
+         * @param result the result of this CliParser
+         * @param ignoreUnknownOptions flag that determines whether unknown options are ignored
+         * @param suppressMissingRequiredOptionsError flag that determines whether missing required options are ignored
+         * @return ParseError the first error found
+         */
+        ParseError _parseSubcommand(size_type sub, int argc, char* argv[], int offset, ParseResult& result, bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError) const;
 
-        std::string appName;  ///< name of the application
-        std::string executablePath;  ///< path of the executable file
-        std::string descr;  ///< description of the application BadOptionFormatError
-        std::string ver; ///< version
-        option_dictionary cliOptions;  ///< dictionary of options
+#ifdef LIBCLIPARSER_STATS
+        /**
+         * @brief _tryParse, instrumented: reset the statistics of result, time the parse and call the hook (see CliParser::onParseStats)
+         * 
+         * @param argc argument counter
+         * @param argv argument value
+         * @param result the result
+         * @param ignoreUnknownOptions flag that determines whether unknown options are ignored
+         * @param suppressMissingRequiredOptionsError flag that determines whether missing required options are ignored
+         * @param throwing true if the caller throws on error (CliParser::parse): the exception is counted before the hook is called
+         * @return ParseError the first error found
+         */
+        ParseError _tryParseWithStats(int argc, char* argv[], ParseResult& result, bool ignoreUnknownOptions, bool suppressMissingRequiredOptionsError, bool throwing) const;
+#endif
+
+        _detail::StringPool strings;  ///< the names and descriptions of the application, the options, the subcommands and the environment variables. It must be declared first
+        std::string_view appName;  ///< name of the application
+        std::string_view descr;  ///< description of the application
+        std::string_view ver; ///< version
+        bool responseFiles = false;  ///< whether @file tokens are expanded
+        bool lazy = false;  ///< whether values are converted on first access
+        bool abbreviations = false;  ///< whether unique prefixes of long options are accepted
+        bool positional = false;  ///< whether positional arguments are collected
+        env_dictionary envNames;  ///< the environment variables declared with CliParser::env
+        option_dictionary configNames;  ///< dictionary of the configuration file keys: option key without its leading dashes -> index in options
+        std::pmr::vector<std::pair<std::pmr::string, bool>> configFiles;  ///< the configuration files (path, required) declared with CliParser::configFile
+        char** envp = nullptr;  ///< the environment, or nullptr for the environment of the process
+        std::size_t helpColumns = 0;  ///< the width of the help, or 0 to use COLUMNS
+        std::pmr::vector<std::unique_ptr<Subcommand>> subcommands;  ///< the subcommands, in declaration order. The CliParser of a subcommand is built lazily, by const parses too
+        option_dictionary subcommandNames;  ///< dictionary of the subcommands: name -> index in subcommands
+#ifdef LIBCLIPARSER_STATS
+        std::function<void(const ParseStats&)> statsHook;  ///< see CliParser::onParseStats
+        std::chrono::nanoseconds schemaBuildTime{};  ///< the time spent in _addOption (see ParseStats::schemaBuild)
+#endif
+        mutable HelpCache helpCache;  ///< the rendered help, built on the first call to help
+        std::uint64_t digest;  ///< the hash of the schema (see CliParser::schemaHash), updated by _addOption
+        _detail::SmallIndex smallIndex;  ///< the index of the options of a small schema (see CliParser::_findOption)
+        option_dictionary cliOptions;  ///< dictionary of options: option key -> index in options. It is filled only when the schema has more options than smallIndex can hold
+        std::pmr::vector<std::string_view> names;  ///< the option keys (held by strings, like the keys of cliOptions), indexed like options: the declaration order
+        std::pmr::vector<std::string_view> sortedNames;  ///< the option keys, sorted: the index used by complete and by the abbreviations
+        std::pmr::vector<size_type> sortedIndices;  ///< sortedIndices[k] is the index in options of sortedNames[k]
+        _detail::DynamicBitset requiredBits;  ///< the i-th bit is set if the i-th option is REQUIRED
+        _detail::DynamicBitset flagBits;  ///< the i-th bit is set if the i-th option is a FLAG (flags are optional)
+        std::pmr::vector<option_variant> options;  ///< all the options, stored contiguously in declaration order
+        ParseResult own;  ///< the values parsed by parse(argc, argv) and tryParse(argc, argv). It must be declared after options
         
     };
 
@@ -612,134 +2363,301 @@ namespace cliparser {
 namespace cliparser {
 
     template <CliParsableArgument Argument>
-    CliParser& CliParser::option(const std::string& opt, const std::string& description) {
-       _preliminaryCheckOptionForProblems(opt);
-
-        // CliParsableArgument cannot be a reference type
-        cliOptions.insert_or_assign(opt, new Option<Argument>(description));
-        
-        return *this;
-    }
-
-    template <CliParsableArgument Argument>
-    CliParser& CliParser::option(const std::string& opt, std::string&& description) {
+    CliParser& CliParser::option(std::string_view opt, std::string_view description) {
        _preliminaryCheckOptionForProblems(opt);
 
         // CliParsableArgument cannot be a reference type
-        cliOptions.insert_or_assign(opt, new Option<Argument>(std::move(description)));
+        Option<_detail::storage_t<Argument>> o(description);
+        if constexpr (_detail::UserArgument<Argument>) o.arg = _detail::UserValue(Argument{});  // the value carries its type
+        _addOption(opt, std::move(o));
         
         return *this;
     }
 
-    template <CliParsableArgumentOrItsReference Argument>
-    CliParser& CliParser::option(const std::string& opt, const std::string& description, Argument&& defaultValue) {
+template <CliParsableArgumentOrItsReference Argument>
+    CliParser& CliParser::option(std::string_view opt, std::string_view description, Argument&& defaultValue) {
         _preliminaryCheckOptionForProblems(opt);
 
         // if we use typename std::decay<Argument>::type we find the option type 
         // remember that this conversion returns a type that is satisfies the CliParsableArgument concept
-        cliOptions.insert_or_assign(opt, new Option<typename std::decay<Argument>::type>(description, std::forward<Argument>(defaultValue)));
+        if constexpr (_detail::UserArgument<typename std::decay<Argument>::type>) _addOption(opt, Option<_detail::UserValue>(description, _detail::UserValue(defaultValue)));
+        else _addOption(opt, Option<typename std::decay<Argument>::type>(description, std::forward<Argument>(defaultValue)));
 
         return *this;
     } 
-    template <CliParsableArgumentOrItsReference Argument>
-    CliParser& CliParser::option(const std::string& opt, std::string&& description, Argument&& defaultValue) {
-        _preliminaryCheckOptionForProblems(opt);
+template <CliParsableArgument Argument>
+    CliParser& CliParser::option(std::string_view opt, std::string_view description, OptionHandle<Argument>& handle) {
+        option<Argument>(opt, description);
+        handle = OptionHandle<Argument>(options.size() - 1);
 
-        // if we use typename std::decay<Argument>::type we find the option type 
-        // remember that this conversion returns a type that is satisfies the CliParsableArgument concept
-        cliOptions.insert_or_assign(opt, new Option<typename std::decay<Argument>::type>(std::move(description), std::forward<Argument>(defaultValue)));
+        return *this;
+    }
+
+    template <CliParsableArgumentOrItsReference Argument>
+    CliParser& CliParser::option(std::string_view opt, std::string_view description, Argument&& defaultValue, OptionHandle<typename std::decay<Argument>::type>& handle) {
+        option(opt, description, std::forward<Argument>(defaultValue));
+        handle = OptionHandle<typename std::decay<Argument>::type>(options.size() - 1);
 
         return *this;
-    } 
+    }
+
+    inline ParseResult::ParseResult(const CliParser& parser, std::pmr::memory_resource* resource) 
+        : schema(&parser), values(resource != nullptr ? resource : parser.get_allocator().resource()), setByUser(values.get_allocator().resource()), 
+        fromEnvironment(values.get_allocator().resource()), fromConfigFile(values.get_allocator().resource()), pending(values.get_allocator()), 
+        mappedFiles(values.get_allocator()), positionalArgs(values.get_allocator()), subResult(values.get_allocator()) {
+        _sync();
+    }
+
+    inline bool ParseResult::_isOwn() const noexcept {
+        return this == &schema->own;
+    }
+
+    inline void ParseResult::_sync() {
+        // no reserve: _sync is called once per added option, and an exact reserve would reallocate at every call (emplace_back grows geometrically)
+        setByUser.resize(schema->options.size());
+        fromEnvironment.resize(schema->options.size());
+        fromConfigFile.resize(schema->options.size());
+        pending.resize(schema->options.size());
+        for (CliParser::size_type i = values.size(); i < schema->options.size(); ++i) {
+            // copy the default value of the i-th option. _detail::argument_variant guarantees that the variant index of the value is that of the option
+            std::visit([this](const auto& o) {
+                // the value of a bound option is in its target: an empty value keeps the alternative without copying the default
+                if (o.target != nullptr && _isOwn()) values.emplace_back(std::in_place_type<std::remove_cvref_t<decltype(o.arg)>>);
+                else values.emplace_back(o.arg);
+            }, schema->options[i]);
+        }
+    }
+
+    template <CliParsableArgument Argument>
+    _detail::option_return_t<Argument> ParseResult::getOption(std::string_view opt) const {
+        return _getOption<Argument>(schema->_getOptionIndex(opt), opt);
+    }
+
+    template <CliParsableArgument Argument>
+    _detail::option_return_t<Argument> ParseResult::_getOption(std::size_t i, std::string_view opt) const {
+        // a required option is available only if set by the user. Options added after the creation of this result are not set by the user (test returns false beyond the size)
+        if (schema->requiredBits.test(i) && !setByUser.test(i)) {
+            LIBCLIPARSER_STATS_ONLY(++parseStats.exceptions;)
+            LIBCLIPARSER_THROW(BadOptionAccessException(opt));
+        }
+        // checking the variant index is the type check: get_if returns nullptr if Argument is not the type of the option
+        // no need for typename std::decay<Argument>::type since we know that std::is_reference<Argument>::value is false (thanks to the definition of the CliParsableArgument concept)
+        // a user-defined type is stored in a _detail::UserValue, whose type tag is the type check
+        using Stored = _detail::storage_t<Argument>;
+        if (i >= values.size()) {
+            // the option is not in this result yet: its value is the default one
+            const CliParser::Option<Stored>* typed = std::get_if<CliParser::Option<Stored>>(&schema->options[i]);
+            if (!_detail::holds<Argument>(typed != nullptr ? &typed->arg : nullptr)) {
+                LIBCLIPARSER_STATS_ONLY(++parseStats.exceptions;)
+                LIBCLIPARSER_THROW(BadOptionCastException(opt));
+            }
+            return _detail::unwrap<Argument>(typed->arg);
+        }
+        const Stored* typed = std::get_if<Stored>(&values[i]);
+        if (!_detail::holds<Argument>(typed)) {
+            LIBCLIPARSER_STATS_ONLY(++parseStats.exceptions;)
+            LIBCLIPARSER_THROW(BadOptionCastException(opt));
+        }
+        if (pending[i].data() != nullptr) _convertPending(i, opt);  // lazy conversion: the value is converted in place
+        return _detail::unwrap<Argument>(*typed);
+    }
+
+    inline OptionSource ParseResult::source(std::string_view opt) const {
+        CliParser::size_type i = schema->_getOptionIndex(opt);
+        if (!setByUser.test(i)) return OptionSource::DEFAULT;
+        if (fromConfigFile.test(i)) return OptionSource::CONFIG_FILE;
+        return fromEnvironment.test(i) ? OptionSource::ENVIRONMENT : OptionSource::COMMAND_LINE;
+    }
+
+    inline bool ParseResult::isOptionSetByUser(std::string_view opt) const {
+        return setByUser.test(schema->_getOptionIndex(opt));
+    }
 
     /**
      * 
-     * Please note that each CliParser::parseArg template specialisation could either be declared here and defined in a .cpp file or defined here as inline.
+     * Please note that each CliParser::_convertArg template specialisation could either be declared here and defined in a .cpp file or defined here as inline.
      * Those that appear small enough will be defined here as inline
      * 
      *  
      */
 
     /**
-     * @brief specialisation of CliParser::parseArg with Argument = int. This function calls std::stoi
+     * @brief specialisation of CliParser::_convertArg with Argument = int. This function calls std::from_chars
      * 
      * @param input the input
-     * @return int the parsed integer
+     * @param value the parsed integer
+     * @return std::errc the result of the conversion
      */
-    template <> inline int CliParser::parseArg<int>(const char* input) {
-        return std::stoi(input);
+    template <> inline std::errc CliParser::_convertArg<int>(std::string_view input, int& value) {
+        return _fromChars(input, value);
     }
     
     /**
-     * @brief specialisation of CliParser::parseArg with Argument = long. This function calls std::stol
+     * @brief specialisation of CliParser::_convertArg with Argument = long. This function calls std::from_chars
+     * 
+     * @param input the input
+     * @param value the parsed integer
+     * @return std::errc the result of the conversion
+     */
+    template <> inline std::errc CliParser::_convertArg<long>(std::string_view input, long& value) {
+        return _fromChars(input, value);
+    }
+
+    /**
+     * @brief specialisation of CliParser::_convertArg with Argument = long long. This function calls std::from_chars
+     * 
+     * @param input the input
+     * @param value the parsed integer
+     * @return std::errc the result of the conversion
+     */
+    template <> inline std::errc CliParser::_convertArg<long long>(std::string_view input, long long& value) {
+        return _fromChars(input, value);
+    }
+
+    /**
+     * @brief specialisation of CliParser::_convertArg with Argument = float. This function calls std::from_chars
+     * 
+     * @param input the input
+     * @param value the parsed number
+     * @return std::errc the result of the conversion
+     */
+    template <> inline std::errc CliParser::_convertArg<float>(std::string_view input, float& value) {
+        return _fromChars(input, value);
+    }
+
+    /**
+     * @brief specialisation of CliParser::_convertArg with Argument = double. This function calls std::from_chars
+     * 
+     * @param input the input
+     * @param value the parsed number
+     * @return std::errc the result of the conversion
+     */
+    template <> inline std::errc CliParser::_convertArg<double>(std::string_view input, double& value) {
+        return _fromChars(input, value);
+    }
+
+    /**
+     * @brief specialisation of CliParser::_convertArg with Argument = long double. This function calls std::from_chars
+     * 
+     * @param input the input
+     * @param value the parsed number
+     * @return std::errc the result of the conversion
+     */
+    template <> inline std::errc CliParser::_convertArg<long double>(std::string_view input, long double& value) {
+        return _fromChars(input, value);
+    }
+
+    /**
+     * @brief specialisation of CliParser::_convertArg with Argument = std::string. This function assigns the input to value
+     * 
+     * @param input the input
+     * @param value the parsed string
+     * @return std::errc std::errc()
+     */
+    template <> inline std::errc CliParser::_convertArg<std::string>(std::string_view input, std::string& value) {
+        value.assign(input);
+        return std::errc();
+    }
+
+    /**
+     * @brief specialisation of CliParser::_convertArg with Argument = std::string_view. This function makes value refer to the input: nothing is copied
      * 
      * @param input the input
-     * @return long the parsed integer
+     * @param value the view of the input
+     * @return std::errc std::errc()
      */
-    template <> inline long CliParser::parseArg<long>(const char* input) {
-        return std::stol(input);
+    template <> inline std::errc CliParser::_convertArg<std::string_view>(std::string_view input, std::string_view& value) {
+        value = input;
+        return std::errc();
     }
 
     /**
-     * @brief specialisation of CliParser::parseArg with Argument = long long. This function calls std::stoll
+     * @brief specialisation of CliParser::_convertArg with Argument = _detail::UserValue. This function calls ArgumentTraits<T>::parse, where T is the user-defined type of the value
      * 
      * @param input the input
-     * @return long long the parsed integer
+     * @param value the value
+     * @return std::errc the result of ArgumentTraits<T>::parse
      */
-    template <> inline long long CliParser::parseArg<long long>(const char* input) {
-        return std::stoll(input);
+    template <> inline std::errc CliParser::_convertArg<_detail::UserValue>(std::string_view input, _detail::UserValue& value) {
+        return value.parse(input);
     }
 
     /**
-     * @brief specialisation of CliParser::parseArg with Argument = float. This function calls std::stof
+     * @brief specialisation of CliParser::_convertArg with Argument = bool. 
+     * 
+     * This function compares the input with "y", "true", "n" and "false", ignoring the case, without copying it. If no comparison matches, the input is rejected and std::errc::invalid_argument is returned 
+     * 
+     * @param input the input
+     * @param value true if the input is either "y" or "true" (ignoring the case), false if the input is either "n" or "false" (ignoring the case)
+     * @return std::errc the result of the conversion
+     */
+    template <> std::errc CliParser::_convertArg<bool>(std::string_view input, bool& value);
+
+    /**
+     * @brief specialisation of CliParser::_convertArg with Argument = std::vector<int>. The input is a comma-separated list (see CliParser::_convertList)
      * 
      * @param input the input
-     * @return float the parsed integer
+     * @param value the parsed list
+     * @return std::errc the result of the conversion
      */
-    template <> inline float CliParser::parseArg<float>(const char* input) {
-        return std::stof(input);
+    template <> inline std::errc CliParser::_convertArg<std::vector<int>>(std::string_view input, std::vector<int>& value) {
+        return _convertList(input, value);
     }
 
     /**
-     * @brief specialisation of CliParser::parseArg with Argument = double. This function calls std::stod
+     * @brief specialisation of CliParser::_convertArg with Argument = std::vector<long>. The input is a comma-separated list (see CliParser::_convertList)
      * 
      * @param input the input
-     * @return double the parsed integer
+     * @param value the parsed list
+     * @return std::errc the result of the conversion
      */
-    template <> inline double CliParser::parseArg<double>(const char* input) {
-        return std::stod(input);
+    template <> inline std::errc CliParser::_convertArg<std::vector<long>>(std::string_view input, std::vector<long>& value) {
+        return _convertList(input, value);
     }
 
     /**
-     * @brief specialisation of CliParser::parseArg with Argument = long double. This function calls std::stold
+     * @brief specialisation of CliParser::_convertArg with Argument = std::vector<long long>. The input is a comma-separated list (see CliParser::_convertList)
      * 
      * @param input the input
-     * @return long double the parsed integer
+     * @param value the parsed list
+     * @return std::errc the result of the conversion
      */
-    template <> inline long double CliParser::parseArg<long double>(const char* input) {
-        return std::stold(input);
+    template <> inline std::errc CliParser::_convertArg<std::vector<long long>>(std::string_view input, std::vector<long long>& value) {
+        return _convertList(input, value);
     }
 
     /**
-     * @brief specialisation of CliParser::parseArg with Argument = std::string. This function calls the string constructor
+     * @brief specialisation of CliParser::_convertArg with Argument = std::vector<float>. The input is a comma-separated list (see CliParser::_convertList)
      * 
      * @param input the input
-     * @return std::string the parsed integer
+     * @param value the parsed list
+     * @return std::errc the result of the conversion
      */
-    template <> inline std::string CliParser::parseArg<std::string>(const char* input) {
-        return std::string(input);
+    template <> inline std::errc CliParser::_convertArg<std::vector<float>>(std::string_view input, std::vector<float>& value) {
+        return _convertList(input, value);
     }
 
     /**
-     * @brief specialisation of CliParser::parseArg with Argument = bool. 
+     * @brief specialisation of CliParser::_convertArg with Argument = std::vector<double>. The input is a comma-separated list (see CliParser::_convertList)
      * 
-     * This function copies the input, converts it to lowercase and compares it with "y", "true", "n" and "false". If no comparison returns true, the input is rejected and std::invalid_argument is thrown 
+     * @param input the input
+     * @param value the parsed list
+     * @return std::errc the result of the conversion
+     */
+    template <> inline std::errc CliParser::_convertArg<std::vector<double>>(std::string_view input, std::vector<double>& value) {
+        return _convertList(input, value);
+    }
+
+    /**
+     * @brief specialisation of CliParser::_convertArg with Argument = std::vector<long double>. The input is a comma-separated list (see CliParser::_convertList)
      * 
      * @param input the input
-     * @return true if the input is either "y" or "true" (ignoring the case)
-     * @return false otherwise if the input is either "n" or "false" (ignoring the case)
+     * @param value the parsed list
+     * @return std::errc the result of the conversion
      */
-    template <> bool CliParser::parseArg<bool>(const char* input);
+    template <> inline std::errc CliParser::_convertArg<std::vector<long double>>(std::string_view input, std::vector<long double>& value) {
+        return _convertList(input, value);
+    }
 
 }
 
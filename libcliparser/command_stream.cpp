@@ -0,0 +1,89 @@
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <libcliparser/command_stream.h>
+
+namespace cliparser {
+
+    bool CommandStream::next() {
+        // the previous command line is consumed: its bytes are reused by the next read
+        begin = pos;
+        tokens.clear();
+        bool complete = false;
+        while (!complete) {
+            // memchr finds the end of each token: the bytes are scanned once, even if a command line spans several reads
+            while (pos < end) {
+                const char* nul = static_cast<const char*>(std::memchr(buffer.data() + pos, '\0', end - pos));
+                if (nul == nullptr) break;  // the token is not complete yet
+                const std::size_t nulPos = static_cast<std::size_t>(nul - buffer.data());
+                if (nulPos == pos) {
+                    // an empty token terminates the command line. An empty command line is skipped
+                    ++pos;
+                    if (!tokens.empty()) {
+                        complete = true;
+                        break;
+                    }
+                    begin = pos;
+                    continue;
+                }
+                tokens.push_back(pos - begin);
+                pos = nulPos + 1;
+            }
+            if (complete) break;
+
+            if (!_fill()) {
+                if (err != 0) return false;
+                // the end of the stream terminates the last token and the last command line
+                if (pos < end) {
+                    if (end == buffer.size()) buffer.push_back('\0');
+                    else buffer[end] = '\0';
+                    tokens.push_back(pos - begin);
+                    pos = ++end;
+                }
+                if (tokens.empty()) return false;
+                complete = true;
+            }
+        }
+
+        args.clear();
+        args.push_back(program.data());
+        for (std::size_t offset : tokens) args.push_back(buffer.data() + begin + offset);
+        args.push_back(nullptr);
+        return true;
+    }
+
+    bool CommandStream::_fill() {
+        if (begin > 0 && buffer.size() - end < buffer.size() / 2) {
+            // move the current command line to the front: the offsets in tokens are relative to begin, therefore they stay valid
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            pos -= begin;
+            end -= begin;
+            begin = 0;
+        }
+        if (end == buffer.size()) buffer.resize(buffer.size() * 2);  // the command line does not fit in the buffer
+
+        for (;;) {
+#ifdef _WIN32
+            const int n = ::_read(fd, buffer.data() + end, static_cast<unsigned int>(buffer.size() - end));
+#else
+            const ::ssize_t n = ::read(fd, buffer.data() + end, buffer.size() - end);
+#endif
+            if (n > 0) {
+                end += static_cast<std::size_t>(n);
+                return true;
+            }
+            if (n == 0) return false;
+            if (errno == EINTR) continue;  // interrupted by a signal before reading anything
+            err = errno;
+            return false;
+        }
+    }
+
+}
@@ -0,0 +1,127 @@
+/**
+ * @file command_stream.h
+ * @brief defines cliparser::CommandStream, a reader of NUL-delimited command lines from a file descriptor, for long-running workers.
+ * @version 1.0
+ * @date 2021-07-17
+ *
+ * The input is framed like the input of `xargs -0`: every token is terminated by a NUL byte, and an empty token (i.e. two consecutive NUL bytes) terminates a command line.
+ * An empty value can still be passed in the "-s=" form.
+ *
+ * The bytes are read into a buffer that is reused for the whole stream: the tokens are not copied, and they are already the NUL-terminated strings that CliParser::tryParse reads.
+ * Only a table of pointers into the buffer (argv) is rebuilt for every command, in storage that is reused too.
+ *
+ * example:
+ *
+ * cliparser::CommandStream commands(STDIN_FILENO, "worker");
+ * cliparser::ParseResult result(parser);
+ * while (commands.next()) {
+ *     if (cliparser::ParseError err = commands.tryParse(parser, result)) std::cerr << err.message() << '\n';
+ *     else run(result);
+ * }
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef LIBCLIPARSER_COMMAND_STREAM_H
+#define LIBCLIPARSER_COMMAND_STREAM_H
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <libcliparser/cliparser.h>  // cliparser::CliParser and cliparser::ParseResult
+#include <libcliparser/parse_error.h>  // cliparser::ParseError, returned by CommandStream::tryParse
+
+namespace cliparser {
+
+    /**
+     * @brief CommandStream class. It reads NUL-delimited command lines from a file descriptor (a pipe, a socket, a file) that it does not own. Objects of this class cannot be copied
+     *
+     */
+    class CommandStream {
+        public:
+        static constexpr std::size_t defaultCapacity = 64 * 1024;  ///< the initial size of the buffer
+
+        /**
+         * @brief Construct a new CommandStream object
+         *
+         * @param fd the file descriptor to read from. It is not closed by the destructor
+         * @param program argv[0] of every command line (see ParseResult::executablePath)
+         * @param capacity the initial size of the buffer. The buffer grows if a command line does not fit in it
+         */
+        explicit CommandStream(int fd, std::string_view program = "", std::size_t capacity = defaultCapacity)
+            : fd(fd), program(program), buffer(capacity > 0 ? capacity : 1), args{this->program.data(), nullptr} {}
+
+        CommandStream(const CommandStream&) = delete;
+        CommandStream& operator=(const CommandStream&) = delete;
+
+        /**
+         * @brief read the next command line. The tokens of the previous command line are no longer valid
+         *
+         * At the end of the stream, a last command line without its terminating empty token (or a last token without its NUL byte) is returned as well
+         *
+         * @return true if a command line was read: see argc and argv
+         * @return false at the end of the stream or if the file descriptor cannot be read (see error)
+         */
+        bool next();
+
+        /**
+         * @brief get the number of tokens of the current command line, argv[0] included
+         *
+         * @return int the argument counter
+         */
+        [[nodiscard]] int argc() const noexcept {return static_cast<int>(args.size()) - 1;}
+
+        /**
+         * @brief get the tokens of the current command line. argv()[0] is the program given to the constructor and argv()[argc()] is nullptr.
+         * The tokens point into the buffer of this object: they are valid until the next call to next
+         *
+         * @return char** the argument value
+         */
+        [[nodiscard]] char** argv() noexcept {return args.data();}
+
+        /**
+         * @brief reset result and parse the current command line into it (see CliParser::tryParse).
+         * The views held by result and by the returned ParseError are valid until the next call to next
+         *
+         * @param parser the parser
+         * @param result the result, created from parser
+         * @param ignoreUnknownOptions if true, unknown options are skipped
+         * @param suppressMissingRequiredOptionsError if true, missing required options are not reported
+         * @return ParseError the first error found, or a ParseError with code ParseErrc::OK
+         */
+        ParseError tryParse(const CliParser& parser, ParseResult& result, bool ignoreUnknownOptions=false, bool suppressMissingRequiredOptionsError=false) {
+            result.reset();
+            return parser.tryParse(argc(), argv(), result, ignoreUnknownOptions, suppressMissingRequiredOptionsError);
+        }
+
+        /**
+         * @brief get the error of the last read
+         *
+         * @return int the errno of the read that failed, or 0 if next returned false at the end of the stream
+         */
+        [[nodiscard]] int error() const noexcept {return err;}
+
+        private:
+        /**
+         * @brief read more bytes after end. The unread bytes are moved to the front of the buffer first if the free space is small, and the buffer grows if it is full
+         *
+         * @return true if at least one byte was read
+         * @return false at the end of the stream or on error (see err)
+         */
+        bool _fill();
+
+        int fd;  ///< the file descriptor
+        std::string program;  ///< argv[0]
+        std::vector<char> buffer;  ///< the bytes read and not consumed yet, in [begin, end)
+        std::size_t begin = 0;  ///< the first byte of the current command line
+        std::size_t pos = 0;  ///< the first byte that has not been split into tokens yet
+        std::size_t end = 0;  ///< one past the last byte read
+        std::vector<std::size_t> tokens;  ///< the offsets of the tokens of the current command line, from begin: they survive the compaction of the buffer
+        std::vector<char*> args;  ///< argv of the current command line
+        int err = 0;  ///< the errno of the last read, or 0
+    };
+
+}
+
+#endif  // LIBCLIPARSER_COMMAND_STREAM_H
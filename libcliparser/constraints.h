@@ -0,0 +1,131 @@
+/**
+ * @file constraints.h
+ * @brief ready-made constraints for cliparser::CliParser::constrain: cliparser::InRange, cliparser::AtLeast, cliparser::AtMost, cliparser::Range, cliparser::OneOf and cliparser::ExistingPath.
+ * @version 1.0
+ * @date 2021-07-17
+ *
+ * A constraint is a predicate with a member type argument_type, the type of the options it applies to.
+ * Any other callable that takes a const Argument& can be used as well, with CliParser::constrain<Argument>.
+ * The bounds of InRange, AtLeast and AtMost are template arguments: they are checked at compile time and the comparisons are against constants.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef LIBCLIPARSER_CONSTRAINTS_H
+#define LIBCLIPARSER_CONSTRAINTS_H
+#include <algorithm>
+#include <concepts>
+#include <filesystem>
+#include <initializer_list>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace cliparser {
+
+    /**
+     * @brief InRange struct template: the value must be in [Min, Max]. The bounds are known at compile time
+     *
+     * example: parser.option("-n", "times", 1).constrain("-n", cliparser::InRange<1, 100>{});
+     *
+     * @tparam Min the lower bound. Its type is the type of the option
+     * @tparam Max the upper bound, of the same type
+     */
+    template <auto Min, auto Max>
+    requires std::same_as<decltype(Min), decltype(Max)> && std::totally_ordered<decltype(Min)>
+    struct InRange {
+        static_assert(Min <= Max, "cliparser::InRange: the range is empty (Min > Max)");
+        using argument_type = decltype(Min);  ///< the type of the options
+
+        /**
+         * @brief check the value
+         *
+         * @param value the value
+         * @return true if Min <= value <= Max
+         * @return false otherwise
+         */
+        constexpr bool operator()(const argument_type& value) const noexcept {return Min <= value && value <= Max;}
+    };
+
+    template <auto Min> using AtLeast = InRange<Min, std::numeric_limits<decltype(Min)>::max()>;  ///< the value must be at least Min
+    template <auto Max> using AtMost = InRange<std::numeric_limits<decltype(Max)>::lowest(), Max>;  ///< the value must be at most Max
+
+    /**
+     * @brief Range struct template: the value must be in [min, max]. The bounds are known at run time (see InRange otherwise)
+     *
+     * @tparam Argument the type of the options
+     */
+    template <typename Argument>
+    struct Range {
+        using argument_type = Argument;  ///< the type of the options
+        Argument min;  ///< the lower bound
+        Argument max;  ///< the upper bound
+
+        /**
+         * @brief check the value
+         *
+         * @param value the value
+         * @return true if min <= value <= max
+         * @return false otherwise
+         */
+        constexpr bool operator()(const Argument& value) const noexcept {return min <= value && value <= max;}
+    };
+
+    template <typename Argument> Range(Argument, Argument) -> Range<Argument>;  ///< deduction guide: Range{1, 10} is a Range<int>
+
+    /**
+     * @brief OneOf struct template: the value must be one of a set of allowed values
+     *
+     * example: parser.option<std::string>("--mode", "mode").constrain("--mode", cliparser::OneOf<std::string>{"fast", "safe"});
+     *
+     * @tparam Argument the type of the options
+     */
+    template <typename Argument>
+    struct OneOf {
+        using argument_type = Argument;  ///< the type of the options
+
+        /**
+         * @brief Construct a new OneOf object
+         *
+         * @param allowed the allowed values
+         */
+        OneOf(std::initializer_list<Argument> allowed) : allowed(allowed) {}
+
+        /**
+         * @brief check the value. The allowed values are few: a linear search is the fastest
+         *
+         * @param value the value
+         * @return true if value is one of the allowed values
+         * @return false otherwise
+         */
+        bool operator()(const Argument& value) const {return std::find(allowed.begin(), allowed.end(), value) != allowed.end();}
+
+        std::vector<Argument> allowed;  ///< the allowed values
+    };
+
+    /**
+     * @brief ExistingPath struct template: the value must be the path of an existing file or directory
+     *
+     * @tparam Argument the type of the options: std::string (default) or std::string_view
+     */
+    template <typename Argument = std::string>
+    struct ExistingPath {
+        using argument_type = Argument;  ///< the type of the options
+
+        /**
+         * @brief check the value
+         *
+         * @param value the path
+         * @return true if the path exists
+         * @return false otherwise, or if its status cannot be read
+         */
+        bool operator()(const Argument& value) const {
+            std::error_code ec;
+            return std::filesystem::exists(std::filesystem::path(value), ec);
+        }
+    };
+
+}
+
+#endif  // LIBCLIPARSER_CONSTRAINTS_H
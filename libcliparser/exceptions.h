@@ -11,6 +11,20 @@
 #define LIBCLIPARSER_EXCEPTION_H
 #include <exception>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cstdlib>
+
+/**
+ * @brief LIBCLIPARSER_THROW(exception) throws exception. If the code is compiled without exceptions (e.g. -fno-exceptions), it calls std::abort() instead.
+ * In that case, use CliParser::tryParse to handle the errors of the user input.
+ * 
+ */
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define LIBCLIPARSER_THROW(...) throw __VA_ARGS__
+#else
+#define LIBCLIPARSER_THROW(...) std::abort()
+#endif
 
 namespace cliparser {
 
@@ -35,7 +49,7 @@ namespace cliparser {
          * 
          * @param option the option
          */
-        NoSuchOptionException(const std::string& option) : errorMsg(std::string("Unrecognised option: ") + option) {}
+        NoSuchOptionException(std::string_view option) : errorMsg(std::string("Unrecognised option: ") + std::string(option)) {}
 
         private:
         const std::string errorMsg;  ///< the error message
@@ -62,7 +76,7 @@ namespace cliparser {
          * 
          * @param option the option
          */
-        OptionRedefinitionError(const std::string& option) : errorMsg(std::string("\033[1;31merror\033[0m: attempted to redefine the option \"") + option + std::string("\"")) {}
+        OptionRedefinitionError(std::string_view option) : errorMsg(std::string("\033[1;31merror\033[0m: attempted to redefine the option \"") + std::string(option) + std::string("\"")) {}
 
         private:
         const std::string errorMsg;  ///< the error message
@@ -89,7 +103,7 @@ namespace cliparser {
          * 
          * @param option the option
          */
-        BadOptionFormatError(const std::string& option) : errorMsg(std::string("\033[1;31merror\033[0m: attempted to register an option with invalid characters. Option: \"") + option + std::string("\"")) {}
+        BadOptionFormatError(std::string_view option) : errorMsg(std::string("\033[1;31merror\033[0m: attempted to register an option with invalid characters. Option: \"") + std::string(option) + std::string("\"")) {}
 
         private:
         const std::string errorMsg;  ///< the error message
@@ -153,7 +167,7 @@ namespace cliparser {
          * 
          * @param option the option
          */
-        BadOptionCastException(const std::string& option) : errorMsg(std::string("Wrong type for the option \"") + option + std::string("\"")) {}
+        BadOptionCastException(std::string_view option) : errorMsg(std::string("Wrong type for the option \"") + std::string(option) + std::string("\"")) {}
 
         private:
         const std::string errorMsg;  ///< the error message
@@ -180,7 +194,7 @@ namespace cliparser {
          * 
          * @param option the option
          */
-        BadOptionAccessException(const std::string& option) : errorMsg(std::string("Bad option access. Option: \"") + option + std::string("\"")) {}
+        BadOptionAccessException(std::string_view option) : errorMsg(std::string("Bad option access. Option: \"") + std::string(option) + std::string("\"")) {}
 
         private:
         const std::string errorMsg;  ///< the error message
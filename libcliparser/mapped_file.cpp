@@ -0,0 +1,94 @@
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <libcliparser/mapped_file.h>
+
+namespace cliparser {
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            ptr = other.ptr;
+            len = other.len;
+            other.ptr = nullptr;
+            other.len = 0;
+        }
+        return *this;
+    }
+
+    #ifdef _WIN32
+
+    bool MappedFile::map(const char* path) noexcept {
+        unmap();
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER fileSize;
+        bool ok = GetFileSizeEx(file, &fileSize) != 0;
+        if (ok && fileSize.QuadPart > 0) {
+            // PAGE_WRITECOPY + FILE_MAP_COPY: a private copy-on-write view, as MAP_PRIVATE
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+            ok = mapping != nullptr;
+            if (ok) {
+                void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+                CloseHandle(mapping);  // the view keeps the mapping alive
+                ok = view != nullptr;
+                if (ok) {
+                    ptr = static_cast<char*>(view);
+                    len = static_cast<std::size_t>(fileSize.QuadPart);
+                }
+            }
+        }
+        CloseHandle(file);
+        return ok;
+    }
+
+    void MappedFile::unmap() noexcept {
+        if (ptr != nullptr) UnmapViewOfFile(ptr);
+        ptr = nullptr;
+        len = 0;
+    }
+
+    #else
+
+    bool MappedFile::map(const char* path) noexcept {
+        unmap();
+        int fd = ::open(path, O_RDONLY);
+        if (fd == -1) return false;
+
+        struct stat st;
+        bool ok = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+        if (ok && st.st_size > 0) {
+            // MAP_PRIVATE: the pages are shared with the page cache until they are written (copy-on-write)
+            void* view = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            ok = view != MAP_FAILED;
+            if (ok) {
+                ptr = static_cast<char*>(view);
+                len = static_cast<std::size_t>(st.st_size);
+                ::madvise(view, len, MADV_SEQUENTIAL);  // the file is tokenized front to back
+            }
+        }
+        ::close(fd);  // the mapping does not need the file descriptor
+        return ok;
+    }
+
+    void MappedFile::unmap() noexcept {
+        if (ptr != nullptr) ::munmap(ptr, len);
+        ptr = nullptr;
+        len = 0;
+    }
+
+    #endif
+
+}
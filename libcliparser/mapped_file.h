@@ -0,0 +1,103 @@
+/**
+ * @file mapped_file.h
+ * @brief defines cliparser::MappedFile, a private (copy-on-write) read-write memory mapping of a whole file.
+ * @version 1.0
+ * @date 2021-07-17
+ * 
+ * cliparser::MappedFile is used to read response files (@file arguments) without copying them into heap buffers:
+ * the tokens are unescaped in place, and only the pages that are actually written are copied by the operating system.
+ * The file on disk is never modified.
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+#ifndef LIBCLIPARSER_MAPPED_FILE_H
+#define LIBCLIPARSER_MAPPED_FILE_H
+#include <cstddef>
+#include <string_view>
+
+namespace cliparser {
+
+    /**
+     * @brief MappedFile class. It owns a private mapping of a file, released by the destructor. Objects of this class can be moved, but not copied
+     * 
+     */
+    class MappedFile {
+        public:
+        /**
+         * @brief Construct an empty MappedFile object
+         * 
+         */
+        MappedFile() noexcept = default;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * @brief move constructor. other becomes empty
+         * 
+         * @param other the mapping
+         */
+        MappedFile(MappedFile&& other) noexcept : ptr(other.ptr), len(other.len) {
+            other.ptr = nullptr;
+            other.len = 0;
+        }
+
+        /**
+         * @brief move assignment. The current mapping is released and other becomes empty
+         * 
+         * @param other the mapping
+         * @return MappedFile& *this
+         */
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        /**
+         * @brief Destroy the MappedFile object and release the mapping
+         * 
+         */
+        ~MappedFile() {unmap();}
+
+        /**
+         * @brief map the file at path, releasing the current mapping. The mapping is private: writes to it are not carried to the file
+         * 
+         * @param path the path of the file
+         * @return true if the file was mapped (an empty file is mapped to an empty range)
+         * @return false if the file cannot be opened or mapped. In this case, *this is empty
+         */
+        bool map(const char* path) noexcept;
+
+        /**
+         * @brief release the mapping. *this becomes empty
+         * 
+         */
+        void unmap() noexcept;
+
+        /**
+         * @brief get the first byte of the mapping
+         * 
+         * @return char* the first byte, or nullptr if empty
+         */
+        [[nodiscard]] char* data() noexcept {return ptr;}
+
+        /**
+         * @brief get the size of the mapping
+         * 
+         * @return std::size_t the size in bytes
+         */
+        [[nodiscard]] std::size_t size() const noexcept {return len;}
+
+        /**
+         * @brief get a view of the mapping
+         * 
+         * @return std::string_view the content of the file
+         */
+        [[nodiscard]] std::string_view view() const noexcept {return std::string_view(ptr, len);}
+
+        private:
+        char* ptr = nullptr;  ///< the first byte of the mapping
+        std::size_t len = 0;  ///< the size of the mapping
+    };
+
+}
+
+#endif  // LIBCLIPARSER_MAPPED_FILE_H
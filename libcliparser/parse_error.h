@@ -0,0 +1,71 @@
+/**
+ * @file parse_error.h
+ * @brief structured, non-throwing error reporting for cliparser::CliParser::tryParse.
+ * @version 1.0
+ * @date 2021-07-17
+ *
+ * cliparser::ParseError is a small trivially copyable struct: an error code, the index of the offending argv token and the offending option.
+ * The human-readable message is only built when cliparser::ParseError::message is called.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef LIBCLIPARSER_PARSE_ERROR_H
+#define LIBCLIPARSER_PARSE_ERROR_H
+#include <string>
+#include <string_view>
+
+namespace cliparser {
+
+    /**
+     * @brief ParseErrc enum: the outcome of CliParser::tryParse (and of ParseResult::restore)
+     *
+     */
+    enum class ParseErrc : unsigned char {
+        OK = 0,  ///< no error
+        NO_SUCH_OPTION,  ///< the token is not an option of the parser (see NoSuchOptionException)
+        FLAG_WITH_VALUE,  ///< a value was assigned to a flag with '='
+        MISSING_VALUE,  ///< the last token is an option that requires a value
+        INVALID_VALUE,  ///< the value cannot be converted to the type of the option (e.g. "12abc" for an int)
+        VALUE_OUT_OF_RANGE,  ///< the value does not fit in the type of the option
+        MISSING_REQUIRED_OPTION,  ///< at least one required option was not provided (see MissingRequiredOptionsError)
+        RESPONSE_FILE_TOO_DEEP,  ///< response files (@file) are nested too deeply, e.g. a response file that includes itself
+        AMBIGUOUS_OPTION,  ///< the token is an abbreviation of several options (see CliParser::enableAbbreviations)
+        BAD_CONFIG_FILE,  ///< a configuration file cannot be read, or one of its lines is not valid (see CliParser::configFile)
+        CONSTRAINT_VIOLATION,  ///< the value violates a constraint of the option (see CliParser::constrain)
+        BAD_SNAPSHOT,  ///< the snapshot is truncated, corrupted or of another format version (see ParseResult::restore)
+        SNAPSHOT_SCHEMA_MISMATCH  ///< the snapshot was written for another schema (see ParseResult::restore)
+    };
+
+    /**
+     * @brief ParseError struct. It describes the first error found by CliParser::tryParse.
+     *
+     * It does not own any memory: option refers to the input token (or to the name of the option held by the parser, for MISSING_REQUIRED_OPTION).
+     * Therefore, it is valid as long as the input and the parser are alive.
+     *
+     */
+    struct ParseError {
+        ParseErrc code = ParseErrc::OK;  ///< the error code
+        int index = -1;  ///< the index of the offending token in argv, or -1 if the error is not related to a single token (i.e. MISSING_REQUIRED_OPTION or a value from the environment). For the errors in a configuration file, the line number
+        std::string_view option{};  ///< the offending option (or token, for NO_SUCH_OPTION)
+        std::string_view value{};  ///< the offending value, for INVALID_VALUE, VALUE_OUT_OF_RANGE and CONSTRAINT_VIOLATION
+
+        /**
+         * @brief check whether an error occurred
+         *
+         * @return true if code != ParseErrc::OK
+         * @return false otherwise
+         */
+        explicit operator bool() const noexcept {return code != ParseErrc::OK;}
+
+        /**
+         * @brief build the human-readable message of the error. The message is the same as the one of the exception thrown by CliParser::parse
+         *
+         * @return std::string the message (empty if code == ParseErrc::OK)
+         */
+        [[nodiscard]] std::string message() const;
+    };
+
+}
+
+#endif  // LIBCLIPARSER_PARSE_ERROR_H
@@ -0,0 +1,407 @@
+/**
+ * @file schema.h
+ * @brief This header defines cliparser::Schema, a compile-time alternative to the runtime option dictionary of cliparser::CliParser.
+ * @version 1.0
+ * @date 2021-07-17
+ *
+ * A cliparser::Schema is a type built from string literals and types. Its dispatch table (a perfect hash of the option names) is computed at compile time,
+ * so parsing does not hash any std::string and does not allocate (as long as no std::string option is set and no error occurs).
+ *
+ * example:
+ *
+ * using MySchema = cliparser::Schema<
+ *     cliparser::Opt<"-n", int, "integer">,
+ *     cliparser::OptDefault<"-q", 3.22f, "optional float">,
+ *     cliparser::Flag<"--help", "print help">
+ * >;
+ *
+ * MySchema::Result res;
+ * MySchema::parse(argc, argv, res);
+ * int n = res.get<"-n">();
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef LIBCLIPARSER_SCHEMA_H
+#define LIBCLIPARSER_SCHEMA_H
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <bit>
+#include <type_traits>
+
+#include <libcliparser/cliparser.h>
+#include <libcliparser/exceptions.h>
+
+namespace cliparser {
+
+    /**
+     * @brief FixedString struct. A string literal that can be used as a non-type template parameter
+     *
+     * @tparam N the size of the literal (including the null terminator)
+     */
+    template <std::size_t N>
+    struct FixedString {
+        char value[N]{};  ///< the characters of the literal, including the null terminator
+
+        /**
+         * @brief Construct a new FixedString object from a string literal
+         *
+         * @param str the string literal
+         */
+        constexpr FixedString(const char (&str)[N]) {std::copy_n(str, N, value);}
+
+        /**
+         * @brief get a view of the string (without the null terminator)
+         *
+         * @return constexpr std::string_view the view
+         */
+        constexpr std::string_view view() const {return std::string_view(value, N-1);}
+    };
+
+    /**
+     * @brief a required option of a cliparser::Schema
+     *
+     * @tparam Name the option (e.g. "-n")
+     * @tparam Argument the type of the option. It must satisfy the CliParsableArgument concept
+     * @tparam Description the description of the option
+     */
+    template <FixedString Name, CliParsableArgument Argument, FixedString Description = "">
+    struct Opt {
+        using argument_type = Argument;  ///< the type of the value held by the option
+        static constexpr std::string_view name = Name.view();  ///< the option
+        static constexpr std::string_view description = Description.view();  ///< the description
+        static constexpr bool optional = false;  ///< required option
+        static constexpr bool flag = false;  ///< not a flag
+
+        /**
+         * @brief the value held by the option before parsing
+         *
+         * @return Argument a value-initialised Argument
+         */
+        static Argument defaultValue() {return Argument();}
+    };
+
+    namespace _schema_detail {
+        /**
+         * @brief maps the type of the non-type template parameter used as a default value to the type of the option
+         *
+         * FixedString<N> is mapped to std::string, every other type is kept as it is
+         */
+        template <typename T> struct DefaultArgument {using type = T;};
+        template <std::size_t N> struct DefaultArgument<FixedString<N>> {using type = std::string;};
+    }
+
+    /**
+     * @brief an optional option of a cliparser::Schema. Just like CliParser::option(opt, description, defaultValue), its type is deduced from the default value.
+     * Use cliparser::FixedString("...") for std::string options
+     *
+     * @tparam Name the option (e.g. "-q")
+     * @tparam Default the default value
+     * @tparam Description the description of the option
+     */
+    template <FixedString Name, auto Default, FixedString Description = "">
+    requires CliParsableArgument<typename _schema_detail::DefaultArgument<std::remove_cv_t<decltype(Default)>>::type>
+    struct OptDefault {
+        using argument_type = typename _schema_detail::DefaultArgument<std::remove_cv_t<decltype(Default)>>::type;  ///< the type of the value held by the option
+        static constexpr std::string_view name = Name.view();  ///< the option
+        static constexpr std::string_view description = Description.view();  ///< the description
+        static constexpr bool optional = true;  ///< optional option
+        static constexpr bool flag = false;  ///< not a flag
+
+        /**
+         * @brief the default value of the option
+         *
+         * @return argument_type the default value
+         */
+        static argument_type defaultValue() {
+            if constexpr (std::same_as<argument_type, std::string>) return std::string(Default.view());
+            else return Default;
+        }
+    };
+
+    /**
+     * @brief a flag of a cliparser::Schema. Flags are optional bool options whose default value is false and which cannot be set explicitly with '='
+     *
+     * @tparam Name the flag (e.g. "--help")
+     * @tparam Description the description of the flag
+     */
+    template <FixedString Name, FixedString Description = "">
+    struct Flag {
+        using argument_type = bool;  ///< flags are bool options
+        static constexpr std::string_view name = Name.view();  ///< the option
+        static constexpr std::string_view description = Description.view();  ///< the description
+        static constexpr bool optional = true;  ///< flags are optional
+        static constexpr bool flag = true;  ///< this is a flag
+
+        /**
+         * @brief the default value of a flag
+         *
+         * @return false
+         */
+        static bool defaultValue() {return false;}
+    };
+
+    /**
+     * @brief Schema class template. A set of options known at compile time.
+     *
+     * The names are checked at compile time (no duplicates, no '=' or ' ') and a perfect hash of the names is computed at compile time.
+     * Therefore, each argv token costs one cheap FNV-1a hash, one table access and one comparison.
+     * The values are stored in a Schema::Result object, which holds a std::tuple of the values and a std::bitset of the options set by the user.
+     *
+     * The parsing rules, the accepted values (see CliParser::parseArg) and the exceptions are the same as CliParser::parse.
+     *
+     * @tparam Entries any number of cliparser::Opt, cliparser::OptDefault and cliparser::Flag
+     */
+    template <typename... Entries>
+    class Schema {
+        public:
+        static constexpr std::size_t size = sizeof...(Entries);  ///< number of options
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);  ///< returned by find when the option does not exist
+
+        private:
+        static constexpr std::array<std::string_view, size> _names = {Entries::name...};  ///< the options, in declaration order
+        static constexpr std::array<bool, size> _flags = {Entries::flag...};  ///< whether each option is a flag
+        static constexpr std::array<bool, size> _optional = {Entries::optional...};  ///< whether each option is optional
+
+        /**
+         * @brief FNV-1a hash of str, seeded with seed
+         */
+        static constexpr std::uint32_t _hash(std::string_view str, std::uint32_t seed) noexcept {
+            std::uint32_t h = 2166136261u ^ seed;
+            for (char c : str) {
+                h ^= static_cast<unsigned char>(c);
+                h *= 16777619u;
+            }
+            return h;
+        }
+
+        /**
+         * @brief the perfect hash table: slots[hash(name, seed) & (slots.size()-1)] holds the index of name + 1 (0 means empty)
+         */
+        template <std::size_t TableSize>
+        struct _Table {
+            std::uint32_t seed = 0;  ///< the seed of the hash. 0 means that no perfect hash was found
+            std::array<std::uint32_t, TableSize> slots{};  ///< index + 1 of the option in each slot
+        };
+
+        static constexpr std::size_t _tableSize = std::bit_ceil(2*size + 1);  ///< a power of 2 at least twice as large as the schema
+
+        static consteval bool _validNames() {
+            for (std::size_t i = 0; i < size; ++i) {
+                if (_names[i].empty() || _names[i].find_first_of("= ") != std::string_view::npos) return false;
+                for (std::size_t j = i+1; j < size; ++j) if (_names[i] == _names[j]) return false;
+            }
+            return true;
+        }
+
+        static consteval _Table<_tableSize> _makeTable() {
+            _Table<_tableSize> table;
+            for (std::uint32_t seed = 1; seed < 100000; ++seed) {
+                table.slots = {};
+                bool collision = false;
+                for (std::size_t i = 0; i < size && !collision; ++i) {
+                    std::uint32_t& slot = table.slots[_hash(_names[i], seed) & (_tableSize - 1)];
+                    if (slot != 0) collision = true;
+                    else slot = static_cast<std::uint32_t>(i + 1);
+                }
+                if (!collision) {
+                    table.seed = seed;
+                    return table;
+                }
+            }
+            return table;
+        }
+
+        static_assert(_validNames(), "cliparser::Schema: option names must be unique and must not be empty or contain '=' or ' '");
+        static constexpr _Table<_tableSize> _table = _makeTable();
+        static_assert(_table.seed != 0, "cliparser::Schema: no perfect hash found for the option names");
+
+        public:
+        /**
+         * @brief find the index of opt. This is a constexpr function: when opt is known at compile time, the index is computed at compile time
+         *
+         * @param opt the option
+         * @return std::size_t the index of the option in declaration order, or Schema::npos if opt is not an option of this schema
+         */
+        static constexpr std::size_t find(std::string_view opt) noexcept {
+            std::uint32_t slot = _table.slots[_hash(opt, _table.seed) & (_tableSize - 1)];
+            return (slot != 0 && _names[slot-1] == opt) ? slot-1 : npos;
+        }
+
+        /**
+         * @brief this function checks whether this schema has the option opt
+         *
+         * @param opt the option
+         * @return true if opt is an option of the schema
+         * @return false otherwise
+         */
+        static constexpr bool hasOption(std::string_view opt) noexcept {return find(opt) != npos;}
+
+        /**
+         * @brief the option at index i
+         *
+         * @param i the index, in declaration order
+         * @return constexpr std::string_view the option
+         */
+        static constexpr std::string_view name(std::size_t i) noexcept {return _names[i];}
+
+        /**
+         * @brief Result class. It holds the values of the options of the schema and which of them were set by the user.
+         * A default constructed Result holds the default values.
+         */
+        class Result {
+            public:
+            /**
+             * @brief Construct a new Result object that holds the default values
+             *
+             */
+            Result() : values(Entries::defaultValue()...) {}
+
+            /**
+             * @brief get the value of the option Name. The type is known at compile time and a non-existing option does not compile.
+             * If the option is required and it has not been set by the user, BadOptionAccessException is thrown
+             *
+             * @tparam Name the option
+             * @return const auto& the value of the option
+             */
+            template <FixedString Name>
+            [[nodiscard]] const auto& get() const {
+                constexpr std::size_t i = find(Name.view());
+                static_assert(i != npos, "cliparser::Schema::Result::get: no such option");
+                if (!_optional[i] && !setByUser[i]) LIBCLIPARSER_THROW(BadOptionAccessException(Name.view()));
+                return std::get<i>(values);
+            }
+
+            /**
+             * @brief this function checks whether the option Name was set by the user
+             *
+             * @tparam Name the option
+             * @return true if the option was set by the user
+             * @return false otherwise
+             */
+            template <FixedString Name>
+            [[nodiscard]] bool isSetByUser() const noexcept {
+                constexpr std::size_t i = find(Name.view());
+                static_assert(i != npos, "cliparser::Schema::Result::isSetByUser: no such option");
+                return setByUser[i];
+            }
+
+            /**
+             * @brief the path used to invoke the program (argv[0]), if it was parsed
+             *
+             * @return std::string_view the path
+             */
+            [[nodiscard]] std::string_view executablePath() const noexcept {return exePath;}
+
+            private:
+            friend class Schema;
+            std::tuple<typename Entries::argument_type...> values;  ///< the values of the options, in declaration order
+            std::bitset<size> setByUser;  ///< bit i is set if the i-th option was set by the user
+            std::string_view exePath;  ///< argv[0]
+        };
+
+        /**
+         * @brief parse the input arguments into res. The rules are the same as CliParser::parse
+         *
+         * This function may throw NoSuchOptionException, MissingRequiredOptionsError and std::invalid_argument
+         *
+         * @param argc argument counter
+         * @param argv argument value
+         * @param res the result. Options that are not passed keep their value
+         * @param ignoreUnknownOptions if set to true, it will ignore unknown options. Default=false
+         * @param suppressMissingRequiredOptionsError if set to true, it will not check whether any required option has been set by the user. Default=false
+         */
+        static void parse(int argc, char* argv[], Result& res, bool ignoreUnknownOptions=false, bool suppressMissingRequiredOptionsError=false) {
+            if (argc == 0) return;  // handle corner case: argc == 0. If this is the case, do nothing
+            res.exePath = argv[0];
+            int i = 1;
+            while (i < argc) {
+                std::string_view view(argv[i]);
+                std::string_view::size_type pos = view.find_first_of('=');
+                std::string_view key = (pos != std::string_view::npos) ? view.substr(0, pos) : view;
+                std::size_t idx = find(key);
+                ++i;
+
+                if (idx == npos) {
+                    if (!ignoreUnknownOptions) LIBCLIPARSER_THROW(NoSuchOptionException(key));
+                    continue;
+                }
+
+                if (_flags[idx]) {
+                    if (pos != std::string_view::npos) LIBCLIPARSER_THROW(std::invalid_argument("\033[1;31merror: invalid input\033[0m. Attempted to assign a value to a flag with '='"));
+                    _raisers[idx](res.values);
+                    res.setByUser.set(idx);
+                    continue;
+                }
+
+                const char* input;
+                if (pos != std::string_view::npos) input = argv[i-1] + pos + 1;
+                else if (i < argc) input = argv[i++];
+                else LIBCLIPARSER_THROW(std::invalid_argument(std::string("\033[1;31merror: invalid input\033[0m. Missing value for the option ") + std::string(key)));
+                _setters[idx](res.values, input);
+                res.setByUser.set(idx);
+            }
+
+            if (!suppressMissingRequiredOptionsError && (_requiredMask() & ~res.setByUser).any()) {
+                std::vector<std::string> missingReqOpt;
+                for (std::size_t j = 0; j < size; ++j) {
+                    if (!_optional[j] && !res.setByUser[j]) missingReqOpt.emplace_back(_names[j]);
+                }
+                LIBCLIPARSER_THROW(MissingRequiredOptionsError(missingReqOpt));
+            }
+        }
+
+        private:
+        using _values_type = std::tuple<typename Entries::argument_type...>;
+
+        /**
+         * @brief the mask of the required options
+         */
+        static std::bitset<size> _requiredMask() noexcept {
+            std::bitset<size> mask;
+            for (std::size_t j = 0; j < size; ++j) mask[j] = !_optional[j];
+            return mask;
+        }
+
+        /**
+         * @brief set the I-th value (a flag) to true
+         */
+        template <std::size_t I>
+        static void _raise(_values_type& values) {
+            if constexpr (std::same_as<std::tuple_element_t<I, _values_type>, bool>) std::get<I>(values) = true;
+        }
+
+        /**
+         * @brief set the I-th value from the input, using CliParser::parseArg
+         */
+        template <std::size_t I>
+        static void _set(_values_type& values, const char* input) {
+            std::get<I>(values) = CliParser::parseArg<std::tuple_element_t<I, _values_type>>(input);
+        }
+
+        template <std::size_t... I>
+        static constexpr std::array<void (*)(_values_type&, const char*), size> _makeSetters(std::index_sequence<I...>) {
+            return {&_set<I>...};
+        }
+
+        template <std::size_t... I>
+        static constexpr std::array<void (*)(_values_type&), size> _makeRaisers(std::index_sequence<I...>) {
+            return {&_raise<I>...};
+        }
+
+        static constexpr std::array<void (*)(_values_type&, const char*), size> _setters = _makeSetters(std::make_index_sequence<size>{});  ///< dispatch table: _setters[i] parses the value of the i-th option
+        static constexpr std::array<void (*)(_values_type&), size> _raisers = _makeRaisers(std::make_index_sequence<size>{});  ///< dispatch table: _raisers[i] sets the i-th option (a flag) to true
+    };
+
+}
+
+#endif  // LIBCLIPARSER_SCHEMA_H
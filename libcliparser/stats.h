@@ -0,0 +1,48 @@
+/**
+ * @file stats.h
+ * @brief opt-in instrumentation of cliparser::CliParser: see cliparser::ParseStats.
+ * @version 1.0
+ * @date 2021-07-17
+ *
+ * The instrumentation is compiled only if LIBCLIPARSER_STATS is defined (configure with -DLIBCLIPARSER_STATS=ON: the definition is propagated to the users of the library).
+ * Otherwise, the macros of this header expand to nothing, therefore the parse is exactly the same code as without instrumentation.
+ * LIBCLIPARSER_STATS changes the layout of cliparser::ParseResult and cliparser::CliParser: the library and its users must agree on it.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#ifndef LIBCLIPARSER_STATS_H
+#define LIBCLIPARSER_STATS_H
+
+#ifdef LIBCLIPARSER_STATS
+#include <chrono>
+
+#define LIBCLIPARSER_STATS_ONLY(...) __VA_ARGS__  ///< the statement is compiled only with the instrumentation
+
+namespace cliparser::_detail {
+    /**
+     * @brief PhaseTimer class. It adds the time elapsed between its construction and its destruction to a duration
+     *
+     */
+    class PhaseTimer {
+        public:
+        /**
+         * @brief Construct a new PhaseTimer object and start the timer
+         *
+         * @param total the duration the elapsed time is added to
+         */
+        explicit PhaseTimer(std::chrono::nanoseconds& total) noexcept : total(total), start(std::chrono::steady_clock::now()) {}
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+        ~PhaseTimer() {total += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);}
+
+        private:
+        std::chrono::nanoseconds& total;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+#else
+#define LIBCLIPARSER_STATS_ONLY(...)
+#endif
+
+#endif  // LIBCLIPARSER_STATS_H
@@ -1,12 +1,86 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <span>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <exception>
 #include <cassert>
 #include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <charconv>
+#include <system_error>
+#include <cstddef>
+#include <memory_resource>
 #include <libcliparser/cliparser.h>
 #include <libcliparser/exceptions.h>
+#include <libcliparser/schema.h>
+#include <libcliparser/command_stream.h>
+#include <libcliparser/base64.h>
+
+// user-defined argument types (see cliparser::ArgumentTraits)
+struct Bytes {std::uint64_t count = 0;};
+enum class Color {RED, GREEN, BLUE};
+
+template <> struct cliparser::ArgumentTraits<Bytes> {
+    // a number with an optional binary suffix, e.g. 64MiB
+    static std::errc parse(std::string_view input, Bytes& value) {
+        std::uint64_t count = 0;
+        auto [end, ec] = std::from_chars(input.data(), input.data() + input.size(), count);
+        if (ec != std::errc()) return ec;
+        std::string_view suffix(end, static_cast<std::size_t>(input.data() + input.size() - end));
+        int shift = suffix.empty() ? 0 : suffix == "KiB" ? 10 : suffix == "MiB" ? 20 : suffix == "GiB" ? 30 : -1;
+        if (shift < 0) return std::errc::invalid_argument;
+        if (count > (UINT64_MAX >> shift)) return std::errc::result_out_of_range;
+        value.count = count << shift;
+        return std::errc();
+    }
+};
+
+template <> struct cliparser::ArgumentTraits<Color> {
+    static std::errc parse(std::string_view input, Color& value) {
+        if (input == "red") value = Color::RED;
+        else if (input == "green") value = Color::GREEN;
+        else if (input == "blue") value = Color::BLUE;
+        else return std::errc::invalid_argument;
+        return std::errc();
+    }
+};
+
+// a user-defined type that is not trivially copyable: a count and its unit, e.g. 30s or 5min
+struct Duration {
+    long long count = 0;
+    std::string unit = "s";
+};
+
+template <> struct cliparser::ArgumentTraits<Duration> {
+    static std::errc parse(std::string_view input, Duration& value) {
+        auto [end, ec] = std::from_chars(input.data(), input.data() + input.size(), value.count);
+        if (ec != std::errc()) return ec;
+        value.unit.assign(end, input.data() + input.size());
+        return value.unit.empty() ? std::errc::invalid_argument : std::errc();
+    }
+
+    static std::string format(const Duration& value) {return std::to_string(value.count) + value.unit;}
+};
+
+// a trivially copyable user-defined type too large to be stored in place: 32 bytes in hexadecimal
+struct Digest {std::uint8_t bytes[32] = {};};
+
+template <> struct cliparser::ArgumentTraits<Digest> {
+    static std::errc parse(std::string_view input, Digest& value) {
+        if (input.size() != 2 * sizeof(value.bytes)) return std::errc::invalid_argument;
+        for (std::size_t i = 0; i < sizeof(value.bytes); ++i) {
+            auto [end, ec] = std::from_chars(input.data() + 2 * i, input.data() + 2 * i + 2, value.bytes[i], 16);
+            if (ec != std::errc() || end != input.data() + 2 * i + 2) return std::errc::invalid_argument;
+        }
+        return std::errc();
+    }
+};
+
 int main (int argc, char* argv[]) {
 
     cliparser::CliParser parser("test", "this is a test program for the cliparser library.");
@@ -33,6 +107,7 @@ int main (int argc, char* argv[]) {
     assert(parser.isOptionOptional("-f") == false);
     assert(parser.isOptionFlag("--help"));
     assert(parser.isOptionSetByUser("--help") == false);
+    assert(parser.hasOption(std::string_view("-n=12").substr(0, 2)));  // heterogeneous lookup with a std::string_view
 
     std::vector<std::string> optionVec = parser.getAllPossibleOptions();
     std::cout << "options: ";
@@ -148,6 +223,901 @@ int main (int argc, char* argv[]) {
         std::cout << "Test passed.\n";
     }
 
+    // a test on cliparser::CliParser::parseArg
+    {
+        std::cout << "Testing cliparser::CliParser::parseArg...\n";
+        assert(cliparser::CliParser::parseArg<int>("-12") == -12);
+        assert(cliparser::CliParser::parseArg<int>("+7") == 7);
+        assert(cliparser::CliParser::parseArg<double>("2.5e3") == 2500.0);
+        assert(cliparser::CliParser::parseArg<bool>("TrUe") && !cliparser::CliParser::parseArg<bool>("N"));
+
+        // trailing garbage, empty input and overflow are rejected
+        int rejected = 0;
+        for (const char* bad : {"12abc", "", " 12", "1.5"}) {
+            try {cliparser::CliParser::parseArg<int>(bad);}
+            catch (const std::invalid_argument& e) {++rejected;}
+        }
+        try {cliparser::CliParser::parseArg<int>("99999999999999999999");}
+        catch (const std::out_of_range& e) {++rejected;}
+        try {cliparser::CliParser::parseArg<bool>("yes");}
+        catch (const std::invalid_argument& e) {++rejected;}
+        assert(rejected == 6);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on cliparser::CliParser::tryParse
+    {
+        std::cout << "Testing cliparser::CliParser::tryParse...\n";
+        cliparser::CliParser p("tryparse", "tryParse test");
+        p.option<int>("-n", "integer").flag("-v", "flag");
+
+        char* missingRequired[] = {const_cast<char*>("tryparse"), const_cast<char*>("-v")};
+        cliparser::ParseError err = p.tryParse(2, missingRequired);
+        assert(err.code == cliparser::ParseErrc::MISSING_REQUIRED_OPTION && err.option == "-n");
+
+        char* unknown[] = {const_cast<char*>("tryparse"), const_cast<char*>("-n"), const_cast<char*>("1"), const_cast<char*>("-x")};
+        err = p.tryParse(4, unknown);
+        assert(err && err.code == cliparser::ParseErrc::NO_SUCH_OPTION && err.index == 3 && err.option == "-x");
+
+        char* garbage[] = {const_cast<char*>("tryparse"), const_cast<char*>("-n=12abc")};
+        err = p.tryParse(2, garbage);
+        assert(err.code == cliparser::ParseErrc::INVALID_VALUE && err.index == 1 && err.option == "-n" && err.value == "12abc");
+        std::cerr << err.message() << std::endl;
+
+        char* flagValue[] = {const_cast<char*>("tryparse"), const_cast<char*>("-v=true")};
+        assert(p.tryParse(2, flagValue).code == cliparser::ParseErrc::FLAG_WITH_VALUE);
+
+        char* missingValue[] = {const_cast<char*>("tryparse"), const_cast<char*>("-n")};
+        assert(p.tryParse(2, missingValue).code == cliparser::ParseErrc::MISSING_VALUE);
+
+        char* good[] = {const_cast<char*>("tryparse"), const_cast<char*>("-n"), const_cast<char*>("12")};
+        assert(!p.tryParse(3, good) && p.getOption<int>("-n") == 12);
+        std::cout << "Test passed.\n";
+
+        // a test on cliparser::CliParser::reset
+        std::cout << "Testing cliparser::CliParser::reset...\n";
+        p.option("-s", "string", std::string("default"));
+        char* line[] = {const_cast<char*>("tryparse"), const_cast<char*>("-n=1"), const_cast<char*>("-v"), const_cast<char*>("-s"), const_cast<char*>("a-much-longer-string-than-the-default")};
+        assert(!p.tryParse(5, line) && p.getOption<bool>("-v") && p.isOptionSetByUser("-s"));
+        p.reset();
+        assert(!p.isOptionSetByUser("-n") && !p.isOptionSetByUser("-v") && !p.getOption<bool>("-v") && p.isOptionFlag("-v"));
+        assert(p.getOption<std::string>("-s") == "default");
+        assert(p.tryParse(1, line).code == cliparser::ParseErrc::MISSING_REQUIRED_OPTION);  // -n is required again
+        assert(!p.tryParse(3, good) && p.getOption<int>("-n") == 12);
+        std::cout << "Test passed.\n";
+
+        // a test on cliparser::ParseResult
+        std::cout << "Testing cliparser::ParseResult...\n";
+        const cliparser::CliParser& schema = p;
+        cliparser::ParseResult first(schema), second(schema);
+        assert(first.getOption<std::string>("-s") == "default" && !first.isOptionSetByUser("-s") && first.executablePath().empty());
+        assert(!schema.tryParse(5, line, first));
+        assert(!schema.tryParse(3, good, second));
+        assert(first.getOption<int>("-n") == 1 && first.getOption<bool>("-v") && first.getOption<std::string>("-s") == "a-much-longer-string-than-the-default");
+        assert(second.getOption<int>("-n") == 12 && !second.getOption<bool>("-v") && second.getOption<std::string>("-s") == "default");
+        assert(first.executablePath() == "tryparse" && &first.parser() == &p);
+        assert(p.getOption<int>("-n") == 12);  // the results are independent of the parser's own values
+
+        p.option("--late", "added after the creation of the results", 7);
+        assert(first.getOption<int>("--late") == 7 && !first.isOptionSetByUser("--late"));
+        first.reset();
+        assert(!first.isOptionSetByUser("-n") && first.getOption<std::string>("-s") == "default");
+        assert(schema.tryParse(1, line, first).code == cliparser::ParseErrc::MISSING_REQUIRED_OPTION);
+        std::cout << "Test passed.\n";
+
+        // a test on cliparser::CliParser::tryParseBatch
+        std::cout << "Testing cliparser::CliParser::tryParseBatch...\n";
+        std::vector<std::string> numbers;
+        for (int k = 0; k < 1000; ++k) numbers.push_back(std::to_string(k));
+        std::vector<std::vector<char*>> argvs;
+        for (int k = 0; k < 1000; ++k) {
+            if (k % 10 == 9) argvs.push_back({const_cast<char*>("batch")});  // missing required option
+            else argvs.push_back({const_cast<char*>("batch"), const_cast<char*>("-n"), numbers[k].data()});
+        }
+        std::vector<std::span<char*>> batch(argvs.begin(), argvs.end());
+        std::vector<cliparser::ParseResult> results;
+        std::vector<cliparser::ParseError> errors = schema.tryParseBatch(batch, results, 4);
+        assert(errors.size() == batch.size() && results.size() == batch.size());
+        for (int k = 0; k < 1000; ++k) {
+            if (k % 10 == 9) assert(errors[k].code == cliparser::ParseErrc::MISSING_REQUIRED_OPTION);
+            else assert(!errors[k] && results[k].getOption<int>("-n") == k);
+        }
+        batch.resize(10);  // the results are reused
+        errors = schema.tryParseBatch(batch, results);
+        assert(results.size() == 10 && !errors[3] && results[3].getOption<int>("-n") == 3);
+        std::cout << "Test passed.\n";
+
+        // a test on std::string_view options
+        std::cout << "Testing std::string_view options...\n";
+        p.option("--path", "a view of argv", std::string_view("none"));
+        char* views[] = {const_cast<char*>("views"), const_cast<char*>("-n=3"), const_cast<char*>("--path=/usr/local/bin")};
+        cliparser::ParseResult viewResult(schema);
+        assert(viewResult.getOption<std::string_view>("--path") == "none");
+        assert(!schema.tryParse(3, views, viewResult));
+        std::string_view path = viewResult.getOption<std::string_view>("--path");
+        assert(path == "/usr/local/bin" && path.data() == views[2] + 7);  // no copy: the value points into argv
+        const std::string& byReference = viewResult.getOption<std::string>("-s");
+        assert(&byReference == &viewResult.getOption<std::string>("-s") && byReference == "default");
+        assert(cliparser::CliParser::parseArg<std::string_view>(views[2]).data() == views[2]);
+        std::cout << "Test passed.\n";
+
+        // a test on response files
+        std::cout << "Testing response files...\n";
+        std::filesystem::path dir = std::filesystem::temp_directory_path();
+        std::string outer = (dir / "cliparser_test_outer.rsp").string(), inner = (dir / "cliparser_test_inner.rsp").string(), self = (dir / "cliparser_test_self.rsp").string();
+        std::ofstream(outer) << "-n 5\n-s 'hello world' \"@" << inner << "\"\n";
+        std::ofstream(inner) << "-v -s=esc\\ aped\n";
+        std::ofstream(self) << "@" << self << "\n";
+        std::string outerArg = "@" + outer, selfArg = "@" + self;
+
+        char* rsp[] = {const_cast<char*>("rsp"), outerArg.data(), const_cast<char*>("--late"), const_cast<char*>("8")};
+        cliparser::ParseResult fromFile(schema);
+        assert(schema.tryParse(4, rsp, fromFile).code == cliparser::ParseErrc::NO_SUCH_OPTION);  // disabled by default
+        p.enableResponseFiles();
+        fromFile.reset();
+        assert(!schema.tryParse(4, rsp, fromFile));
+        assert(fromFile.getOption<int>("-n") == 5 && fromFile.getOption<bool>("-v") && fromFile.getOption<std::string>("-s") == "esc aped" && fromFile.getOption<int>("--late") == 8);
+
+        char* rspSelf[] = {const_cast<char*>("rsp"), selfArg.data()};
+        cliparser::ParseError rspErr = schema.tryParse(2, rspSelf, fromFile);
+        assert(rspErr.code == cliparser::ParseErrc::RESPONSE_FILE_TOO_DEEP && rspErr.index == 1);
+        char* rspMissing[] = {const_cast<char*>("rsp"), const_cast<char*>("@cliparser-no-such-file")};
+        assert(schema.tryParse(2, rspMissing, fromFile).option == "@cliparser-no-such-file");  // kept as an ordinary token
+        p.enableResponseFiles(false);
+        for (const std::string& f : {outer, inner, self}) std::filesystem::remove(f);
+        std::cout << "Test passed.\n";
+
+        // a test on cliparser::OptionHandle
+        std::cout << "Testing cliparser::OptionHandle...\n";
+        cliparser::OptionHandle<int> count;
+        cliparser::OptionHandle<double> ratio;
+        cliparser::OptionHandle<bool> quiet;
+        assert(!count.valid());
+        p.option<int>("--count", "a required int", count).option("--ratio", "an optional double", 0.5, ratio).flag("--quiet", "a flag", quiet);
+        assert(count.valid() && ratio.valid() && quiet.valid());
+        char* handles[] = {const_cast<char*>("handles"), const_cast<char*>("-n=1"), const_cast<char*>("--count"), const_cast<char*>("9"), const_cast<char*>("--quiet")};
+        cliparser::ParseResult handleResult(schema);
+        assert(!schema.tryParse(5, handles, handleResult));
+        assert(handleResult.getOption(count) == 9 && handleResult.getOption(ratio) == 0.5 && handleResult.getOption(quiet));
+        cliparser::OptionHandle<std::string_view> pathHandle = schema.handle<std::string_view>("--path");
+        assert(handleResult.getOption(pathHandle) == "none");
+        bool hasExceptionHappened = false;
+        try {
+            (void) schema.handle<long>("--count");
+        }
+        catch (const cliparser::BadOptionCastException& e) {
+            hasExceptionHappened = true;
+        }
+        assert(hasExceptionHappened);
+        std::cout << "Test passed.\n";
+
+        // a test on cliparser::CliParser::bind
+        std::cout << "Testing cliparser::CliParser::bind...\n";
+        struct {int jobs = 4; std::string output = "a.out";} config;
+        p.bind("-j", config.jobs, "number of jobs").bind("-o", config.output, "output file");
+        char* bound[] = {const_cast<char*>("bind"), const_cast<char*>("-n=1"), const_cast<char*>("--count=2"), const_cast<char*>("-o"), const_cast<char*>("out.bin")};
+        p.reset();
+        assert(!p.tryParse(5, bound));
+        assert(config.output == "out.bin" && config.jobs == 4);  // -j was not passed: the target keeps its value
+        assert(p.getOption<std::string>("-o") == "out.bin" && p.isOptionSetByUser("-o") && !p.isOptionSetByUser("-j"));
+        assert(p.getOption(p.handle<int>("-j")) == 4);
+        cliparser::ParseResult boundResult(schema);  // other results never write to the targets
+        char* other[] = {const_cast<char*>("bind"), const_cast<char*>("-n=1"), const_cast<char*>("--count=2"), const_cast<char*>("-j=16")};
+        assert(!schema.tryParse(4, other, boundResult));
+        assert(boundResult.getOption<int>("-j") == 16 && boundResult.getOption<std::string>("-o") == "a.out" && config.jobs == 4);
+        p.reset();
+        assert(config.output == "out.bin");
+        std::cout << "Test passed.\n";
+
+        // a test on lazy conversion
+        std::cout << "Testing cliparser::CliParser::enableLazyConversion...\n";
+        p.enableLazyConversion();
+        char* lazyLine[] = {const_cast<char*>("lazy"), const_cast<char*>("-n=1"), const_cast<char*>("--count=2"), const_cast<char*>("--ratio=abc"), const_cast<char*>("-j=8"), const_cast<char*>("-s=")};
+        cliparser::ParseResult lazyResult(schema);
+        assert(!schema.tryParse(6, lazyLine, lazyResult));  // --ratio is not converted yet
+        assert(lazyResult.isOptionSetByUser("--ratio") && lazyResult.getOption(count) == 2 && lazyResult.getOption<std::string>("-s").empty());
+        int lazyErrors = 0;
+        for (int k = 0; k < 2; ++k) {
+            try {(void) lazyResult.getOption(ratio);}
+            catch (const std::invalid_argument& e) {++lazyErrors;}
+        }
+        assert(lazyErrors == 2);  // the bad token stays pending
+        assert(!p.tryParse(6, lazyLine) && config.jobs == 8);  // bound options are converted during the parse
+        p.enableLazyConversion(false);
+        assert(schema.tryParse(6, lazyLine, lazyResult).code == cliparser::ParseErrc::INVALID_VALUE);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on user-defined argument types
+    {
+        std::cout << "Testing cliparser::ArgumentTraits...\n";
+        static_assert(cliparser::CliParsableArgument<Bytes> && cliparser::CliParsableArgument<Color> && !cliparser::CliParsableArgument<std::vector<std::string>>);
+        cliparser::CliParser custom("custom", "user-defined types test");
+        cliparser::OptionHandle<Color> color;
+        custom.option("--cache", "cache size", Bytes{1 << 20}).option<Bytes>("--limit", "memory limit").option("--color", "color", Color::RED, color);
+        char* customLine[] = {const_cast<char*>("custom"), const_cast<char*>("--limit=64MiB"), const_cast<char*>("--color"), const_cast<char*>("blue")};
+        cliparser::ParseResult customResult(custom);
+        assert(!custom.tryParse(4, customLine, customResult));
+        assert(customResult.getOption<Bytes>("--limit").count == 64u << 20 && customResult.getOption<Bytes>("--cache").count == 1u << 20 && customResult.getOption(color) == Color::BLUE);
+        assert(custom.handle<Bytes>("--limit").valid() && cliparser::CliParser::parseArg<Bytes>("2KiB").count == 2048);
+
+        bool hasExceptionHappened = false;
+        try {(void) customResult.getOption<Color>("--limit");}  // both are user-defined types, with different traits
+        catch (const cliparser::BadOptionCastException& e) {hasExceptionHappened = true;}
+        assert(hasExceptionHappened);
+
+        char* badLine[] = {const_cast<char*>("custom"), const_cast<char*>("--limit=64MB"), const_cast<char*>("--cache=99999999999GiB")};
+        customResult.reset();
+        cliparser::ParseError customErr = custom.tryParse(2, badLine, customResult);
+        assert(customErr.code == cliparser::ParseErrc::INVALID_VALUE && customErr.value == "64MB");
+        badLine[1] = const_cast<char*>("--limit=1");
+        customResult.reset();
+        assert(custom.tryParse(3, badLine, customResult).code == cliparser::ParseErrc::VALUE_OUT_OF_RANGE);
+
+        custom.enableLazyConversion();
+        customResult.reset();
+        assert(!custom.tryParse(4, customLine, customResult) && customResult.getOption(color) == Color::BLUE && customResult.getOption<Bytes>("--limit").count == 64u << 20);
+
+        // types that are not stored in place: a value with a std::string member and a large trivially copyable one
+        static_assert(cliparser::CliParsableArgument<Duration> && cliparser::CliParsableArgument<Digest>);
+        static_assert(std::same_as<cliparser::_detail::option_return_t<Duration>, const Duration&> && std::same_as<cliparser::_detail::option_return_t<Digest>, Digest>);
+        cliparser::CliParser stateful("stateful", "user-defined types on the heap");
+        stateful.option("--timeout", "timeout", Duration{30, "s"}).option<Digest>("--digest", "digest")
+            .constrain<Duration>("--timeout", [](const Duration& d) {return d.unit == "s" || d.unit == "min";});
+        std::string digestToken = "--digest=" + std::string(64, 'a');
+        char* statefulLine[] = {const_cast<char*>("stateful"), const_cast<char*>("--timeout=5min"), digestToken.data()};
+        stateful.parse(3, statefulLine);
+        const Duration& timeout = stateful.getOption<Duration>("--timeout");
+        assert(timeout.count == 5 && timeout.unit == "min" && stateful.getOption<Digest>("--digest").bytes[31] == 0xaa);
+
+        cliparser::ParseResult statefulResult(stateful);
+        char* badUnit[] = {const_cast<char*>("stateful"), const_cast<char*>("--timeout=5h")};
+        assert(stateful.tryParse(2, badUnit, statefulResult).code == cliparser::ParseErrc::CONSTRAINT_VIOLATION && statefulResult.getOption<Duration>("--timeout").unit == "s");
+
+        std::vector<std::byte> statefulSnap = stateful.snapshot();  // the Duration is formatted, the Digest is written as its bytes
+        cliparser::CliParser statefulMoved(std::move(stateful));
+        statefulMoved.reset();
+        assert(statefulMoved.getOption<Duration>("--timeout").count == 30 && !statefulMoved.restore(statefulSnap));
+        assert(statefulMoved.getOption<Duration>("--timeout").unit == "min" && statefulMoved.getOption<Digest>("--digest").bytes[0] == 0xaa);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on constraints
+    {
+        std::cout << "Testing cliparser::CliParser::constrain...\n";
+        cliparser::CliParser checked("checked", "constraints test");
+        int jobs = 2;
+        checked.option("-n", "times", 1).constrain("-n", cliparser::InRange<1, 100>{})
+            .option<std::string>("--mode", "mode").constrain("--mode", cliparser::OneOf<std::string>{"fast", "safe"})
+            .option("-r", "ratio", 0.5).constrain("-r", cliparser::Range{0.0, 1.0})
+            .option("--ids", "ids", std::vector<int>{}).constrain<std::vector<int>>("--ids", [](const std::vector<int>& ids) {return ids.size() <= 3;})
+            .option("--cache", "cache size", Bytes{1024}).constrain<Bytes>("--cache", [](Bytes b) {return b.count % 1024 == 0;})
+            .bind("-j", jobs, "jobs").constrain("-j", cliparser::AtLeast<1>{}).constrain<int>("-j", [](int j) {return j % 2 == 0;});
+        static_assert(cliparser::AtMost<10>{}(10) && !cliparser::AtMost<10>{}(11));
+
+        char* good[] = {const_cast<char*>("checked"), const_cast<char*>("-n=100"), const_cast<char*>("--mode=safe"), const_cast<char*>("-r"), const_cast<char*>("1"), 
+            const_cast<char*>("--ids=1,2"), const_cast<char*>("--cache=4KiB"), const_cast<char*>("-j=4")};
+        assert(!checked.tryParse(8, good) && checked.getOption<int>("-n") == 100 && checked.getOption<std::string>("--mode") == "safe" && jobs == 4);
+
+        auto violation = [&checked](const char* token) {
+            char* line[] = {const_cast<char*>("checked"), const_cast<char*>("--mode=fast"), const_cast<char*>(token)};
+            cliparser::ParseResult r(checked);
+            cliparser::ParseError e = checked.tryParse(3, line, r);
+            return e.code == cliparser::ParseErrc::CONSTRAINT_VIOLATION && e.index == 2 && e.value == std::string_view(token).substr(std::string_view(token).find('=') + 1);
+        };
+        assert(violation("-n=0") && violation("-n=101") && violation("--mode=slow") && violation("-r=1.5") && violation("--ids=1,2,3,4") && violation("--cache=1000"));
+        assert(violation("-j=3") && violation("-j=0") && jobs == 4);  // the bound variable keeps its value
+        char* longList[] = {const_cast<char*>("checked"), const_cast<char*>("--mode=fast"), const_cast<char*>("--ids=1,2"), const_cast<char*>("--ids=3,4"), const_cast<char*>("--ids=5")};
+        cliparser::ParseResult listResult(checked);
+        assert(checked.tryParse(4, longList, listResult).code == cliparser::ParseErrc::CONSTRAINT_VIOLATION);
+        assert((listResult.getOption<std::vector<int>>("--ids") == std::vector<int>{1, 2}));  // the appended values are removed
+        char* shortList[] = {const_cast<char*>("checked"), const_cast<char*>("--mode=fast"), const_cast<char*>("--ids=1,2"), const_cast<char*>("--ids=5")};
+        listResult.reset();
+        assert(!checked.tryParse(4, shortList, listResult) && (listResult.getOption<std::vector<int>>("--ids") == std::vector<int>{1, 2, 5}));
+
+        checked.enableLazyConversion();  // constrained options are converted during the parse
+        assert(violation("-n=0"));
+        checked.enableLazyConversion(false);
+
+        bool hasExceptionHappened = false;
+        try {
+            char* line[] = {const_cast<char*>("checked"), const_cast<char*>("--mode=slow")};
+            checked.parse(2, line);
+        }
+        catch (const std::invalid_argument& e) {
+            std::cerr << e.what() << std::endl;
+            hasExceptionHappened = true;
+        }
+        assert(hasExceptionHappened);
+
+        hasExceptionHappened = false;
+        try {checked.constrain("--mode", cliparser::AtLeast<1>{});}
+        catch (const cliparser::BadOptionCastException& e) {hasExceptionHappened = true;}
+        assert(hasExceptionHappened);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on NUL-delimited command streams
+    {
+        std::cout << "Testing cliparser::CommandStream...\n";
+        cliparser::CliParser worker("worker", "command stream test");
+        worker.option<int>("-n", "integer").flag("-v", "verbose");
+        // the tokens end with NUL, the command lines with an empty token. The last command line is terminated by the end of the stream
+        const char bytes[] = "-n\0" "1\0" "-v\0" "\0" "\0" "-n\0" "22\0" "\0" "-n=x\0" "\0" "-n\0" "3";
+        const std::string_view input(bytes, sizeof(bytes) - 1);
+        std::FILE* file = std::tmpfile();
+        assert(file != nullptr && std::fwrite(input.data(), 1, input.size(), file) == input.size() && std::fflush(file) == 0);
+        std::rewind(file);
+
+        cliparser::CommandStream commands(fileno(file), "worker", 8);  // a tiny buffer: the command lines span several reads
+        cliparser::ParseResult workerResult(worker);
+        assert(commands.next() && commands.argc() == 4 && std::string_view(commands.argv()[0]) == "worker" && commands.argv()[4] == nullptr);
+        assert(!commands.tryParse(worker, workerResult) && workerResult.getOption<int>("-n") == 1 && workerResult.getOption<bool>("-v"));
+        assert(commands.next() && !commands.tryParse(worker, workerResult) && workerResult.getOption<int>("-n") == 22 && !workerResult.getOption<bool>("-v"));  // the empty command line is skipped
+        assert(commands.next());
+        cliparser::ParseError streamErr = commands.tryParse(worker, workerResult);
+        assert(streamErr.code == cliparser::ParseErrc::INVALID_VALUE && streamErr.value == "x" && streamErr.index == 1);
+        assert(commands.next() && !commands.tryParse(worker, workerResult) && workerResult.getOption<int>("-n") == 3);
+        assert(!commands.next() && commands.error() == 0);
+        std::fclose(file);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on list options
+    {
+        std::cout << "Testing list options...\n";
+        cliparser::CliParser l("lists", "list options test");
+        l.option("-i", "ids", std::vector<long>{7}).option<std::vector<double>>("--ratios", "ratios");
+        char* lists[] = {const_cast<char*>("lists"), const_cast<char*>("-i"), const_cast<char*>("1,2"), const_cast<char*>("--ratios=0.5"), const_cast<char*>("-i=+3"), const_cast<char*>("--ratios"), const_cast<char*>("1e3,-2")};
+        cliparser::ParseResult listResult(l);
+        assert(listResult.getOption<std::vector<long>>("-i") == std::vector<long>{7});
+        assert(!l.tryParse(7, lists, listResult));
+        assert(listResult.getOption<std::vector<long>>("-i") == (std::vector<long>{1, 2, 3}));  // the first occurrence replaces the default, the next ones append
+        assert(listResult.getOption<std::vector<double>>("--ratios") == (std::vector<double>{0.5, 1000.0, -2.0}));
+
+        listResult.reset();
+        char* badList[] = {const_cast<char*>("lists"), const_cast<char*>("--ratios="), const_cast<char*>("-i=4,,5")};
+        cliparser::ParseError listErr = l.tryParse(3, badList, listResult);
+        assert(listErr.code == cliparser::ParseErrc::INVALID_VALUE && listErr.value == "4,,5");
+        assert(listResult.getOption<std::vector<long>>("-i") == std::vector<long>{7} && listResult.getOption<std::vector<double>>("--ratios").empty());
+
+        std::string ids = "-i=0";
+        for (int k = 1; k < 100000; ++k) ids += "," + std::to_string(k);
+        char* bigList[] = {const_cast<char*>("lists"), const_cast<char*>("--ratios="), ids.data()};
+        listResult.reset();
+        assert(!l.tryParse(3, bigList, listResult));
+        const std::vector<long>& parsedIds = listResult.getOption<std::vector<long>>("-i");
+        assert(parsedIds.size() == 100000 && parsedIds.back() == 99999 && parsedIds.capacity() == 100001);  // reserved once, from the count of the commas (plus the default element, dropped on success)
+
+        char listEnv[] = "LIST_IDS=8,9";
+        char* listEnvp[] = {listEnv, nullptr};
+        l.env("-i", "LIST_IDS").environment(listEnvp);
+        listResult.reset();
+        assert(!l.tryParse(2, bigList, listResult) && listResult.getOption<std::vector<long>>("-i") == (std::vector<long>{8, 9}));
+        listResult.reset();
+        assert(!l.tryParse(5, lists, listResult) && listResult.getOption<std::vector<long>>("-i") == (std::vector<long>{1, 2, 3}));  // the command line replaces the environment
+
+        assert(cliparser::CliParser::parseArg<std::vector<int>>("1,-2") == (std::vector<int>{1, -2}));
+        bool hasExceptionHappened = false;
+        try {(void) cliparser::CliParser::parseArg<std::vector<int>>("1,99999999999");}
+        catch (const std::out_of_range& e) {hasExceptionHappened = true;}
+        assert(hasExceptionHappened);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on subcommands
+    {
+        std::cout << "Testing cliparser::CliParser::subcommand...\n";
+        cliparser::CliParser git("git", "subcommands test");
+        int builtCommits = 0, builtPushes = 0;
+        git.flag("-v", "verbose")
+            .subcommand("commit", "record changes", [&builtCommits](cliparser::CliParser& commit) {
+                ++builtCommits;
+                commit.option<std::string>("-m", "message").flag("--amend", "amend the last commit");
+            })
+            .subcommand("push", "update the remote", [&builtPushes](cliparser::CliParser& push) {
+                ++builtPushes;
+                push.option("--remote", "remote", std::string("origin"));
+            });
+        assert(git.help(true).find("commands:\n  commit  record changes\n  push    update the remote\n") != std::string::npos && builtCommits == 0);
+
+        char* commitLine[] = {const_cast<char*>("git"), const_cast<char*>("-v"), const_cast<char*>("commit"), const_cast<char*>("-m"), const_cast<char*>("fix"), const_cast<char*>("-v")};
+        cliparser::ParseResult gitResult(git);
+        cliparser::ParseError subErr = git.tryParse(6, commitLine, gitResult);
+        assert(subErr.code == cliparser::ParseErrc::NO_SUCH_OPTION && subErr.index == 5);  // -v after the name belongs to the subcommand
+        assert(builtCommits == 1 && builtPushes == 0);  // only the selected subcommand is built
+
+        gitResult.reset();
+        assert(!git.tryParse(5, commitLine, gitResult) && gitResult.getOption<bool>("-v") && gitResult.subcommand() == "commit");
+        assert(gitResult.subcommandResult()->getOption<std::string>("-m") == "fix" && !gitResult.subcommandResult()->getOption<bool>("--amend"));
+
+        git.parse(5, commitLine);  // the parser's own result
+        assert(git.selectedSubcommand() == "commit" && git.subcommandParser("commit")->getOption<std::string>("-m") == "fix" && builtCommits == 1);
+        assert(git.subcommandParser("push") == nullptr);
+
+        bool hasExceptionHappened = false;
+        try {
+            git.reset();
+            git.parse(3, commitLine);
+        }
+        catch (const cliparser::MissingRequiredOptionsError& e) {
+            std::cerr << e.what() << std::endl;
+            hasExceptionHappened = true;
+        }
+        assert(hasExceptionHappened);  // -m is required by commit
+
+        char* noCommand[] = {const_cast<char*>("git"), const_cast<char*>("-v")};
+        gitResult.reset();
+        assert(!git.tryParse(2, noCommand, gitResult) && gitResult.subcommand().empty() && gitResult.subcommandResult() == nullptr);
+
+        hasExceptionHappened = false;
+        try {git.option<int>("push", "clashes with the subcommand");}
+        catch (const cliparser::OptionRedefinitionError& e) {hasExceptionHappened = true;}
+        assert(hasExceptionHappened);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on std::pmr allocators: the parser and its results live in a buffer on the stack
+    {
+        std::cout << "Testing std::pmr allocators...\n";
+        alignas(std::max_align_t) std::byte buffer[1 << 15];
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        std::pmr::memory_resource* previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());  // a stray allocation from the default resource throws std::bad_alloc
+        {
+            cliparser::CliParser arenaParser("arena", "pmr test", "1.0", &arena);
+            arenaParser.option<int>("-n", "int").option("-x", "double", 1.5).flag("-v", "verbose");
+            assert(arenaParser.get_allocator().resource() == &arena);
+
+            char* line[] = {const_cast<char*>("arena"), const_cast<char*>("-n"), const_cast<char*>("7"), const_cast<char*>("-v")};
+            cliparser::ParseResult arenaResult(arenaParser);
+            assert(!arenaParser.tryParse(4, line, arenaResult) && arenaResult.getOption<int>("-n") == 7 && arenaResult.getOption<bool>("-v"));
+
+            cliparser::CliParser moved(std::move(arenaParser));
+            moved.parse(4, line);  // the parser's own result follows the parser
+            assert(moved.getOption<int>("-n") == 7 && moved.getOption<double>("-x") == 1.5 && moved.hasOption("-v"));
+
+            cliparser::CliParser heapParser("heap", "another resource", "1.0", std::pmr::new_delete_resource());
+            heapParser = std::move(moved);  // the storage is copied to the new_delete_resource, the names and descriptions stay in the arena
+            assert(heapParser.get_allocator().resource() == std::pmr::new_delete_resource() && heapParser.version() == "1.0");
+            heapParser.reset();
+            heapParser.parse(3, line);
+            assert(heapParser.getOption<int>("-n") == 7 && !heapParser.getOption<bool>("-v") && !heapParser.isOptionSetByUser("-x"));
+            assert(heapParser.help(true).find("-x") != std::string::npos);
+            for (cliparser::CliParser* movedFrom : {&arenaParser, &moved}) {  // the moved-from parsers are empty
+                movedFrom->reset();
+                assert(!movedFrom->tryParse(1, line) && !movedFrom->hasOption("-n"));
+            }
+        }
+        std::pmr::set_default_resource(previous);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on the string pool that holds the names and descriptions
+    {
+        std::cout << "Testing the names and descriptions of cliparser::CliParser...\n";
+        cliparser::CliParser pooled("pool", "string pool test");
+        const std::string longDescr(2 * cliparser::_detail::StringPool::chunkSize, 'd');  // longer than a chunk
+        for (int k = 0; k < 300; ++k) {
+            std::string name = "--name" + std::to_string(k);  // destroyed at the end of the iteration: the parser keeps a copy
+            pooled.option(name, k == 150 ? std::string_view(longDescr) : std::string_view("a description"), k);
+        }
+        {
+            std::string envName = "POOL_TEST_VAR";
+            pooled.env("--name7", envName);
+        }
+        assert(pooled.hasOption("--name0") && pooled.hasOption("--name299") && !pooled.hasOption("--name300"));
+        assert(pooled.complete("--name29").size() == 11);
+
+        cliparser::CliParser moved(std::move(pooled));  // the views are not invalidated by a move
+        char* line[] = {const_cast<char*>("pool"), const_cast<char*>("--name150=5"), nullptr};
+        char poolEnv[] = "POOL_TEST_VAR=9";
+        char* poolEnvp[] = {poolEnv, nullptr};
+        moved.environment(poolEnvp);
+        moved.parse(2, line);
+        assert(moved.getOption<int>("--name150") == 5 && moved.getOption<int>("--name7") == 9 && moved.getOption<int>("--name299") == 299);
+        const std::string& movedHelp = moved.help(true);
+        assert(movedHelp.find("--name42") != std::string::npos && movedHelp.find(longDescr.substr(0, 64)) != std::string::npos);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on the lookup of the options, below and above the size of the small index
+    {
+        std::cout << "Testing the lookup of the options...\n";
+        cliparser::CliParser lookup("lookup", "lookup test");
+        std::vector<std::string> lookupNames;
+        for (std::size_t k = 0; k < 2 * cliparser::_detail::SmallIndex::capacity; ++k) {
+            lookupNames.push_back((k % 2 == 0 ? "--a" : "--b") + std::to_string(k / 2) + "-same-tail");  // the tags of --aN-same-tail and --bN-same-tail are equal
+            if (k == 5) lookupNames.back() = std::string(300, 'x');  // longer than the length of a tag
+            lookup.option(lookupNames.back(), "an option", static_cast<int>(k));
+            for (std::size_t j = 0; j <= k; ++j) assert(lookup.hasOption(lookupNames[j]) && lookup.getOption<int>(lookupNames[j]) == static_cast<int>(j));
+            assert(!lookup.hasOption("") && !lookup.hasOption("--c0-same-tail") && !lookup.hasOption(std::string(299, 'x') + "y") && !lookup.hasOption(std::string(301, 'x')));
+        }
+        std::string lookupToken = lookupNames[3] + "=42";
+        char* lookupLine[] = {const_cast<char*>("lookup"), lookupToken.data(), const_cast<char*>("--c0-same-tail")};
+        cliparser::ParseError lookupErr = lookup.tryParse(3, lookupLine);
+        assert(lookupErr.code == cliparser::ParseErrc::NO_SUCH_OPTION && lookupErr.index == 2 && lookup.getOption<int>(lookupNames[3]) == 42);
+
+        cliparser::CliParser small("small", "small index");
+        small.option("-n", "n", 1).flag("-v", "verbose");
+        cliparser::CliParser smallMoved(std::move(small));
+        char* smallLine[] = {const_cast<char*>("small"), const_cast<char*>("-n=3"), const_cast<char*>("-v")};
+        smallMoved.parse(3, smallLine);
+        assert(smallMoved.getOption<int>("-n") == 3 && smallMoved.getOption<bool>("-v") && !smallMoved.hasOption("-x"));
+        assert(!small.hasOption("-n") && !small.hasOption("-v"));  // the moved-from parser is empty and can be reused
+        for (int i = 0; i < 16; ++i) small.option("-o" + std::to_string(i), "option", i);
+        assert(small.hasOption("-o15") && !small.hasOption("-n"));
+        small = std::move(smallMoved);
+        assert(!smallMoved.hasOption("-n") && small.hasOption("-n") && !small.hasOption("-o15"));
+        smallMoved.flag("-q", "quiet");
+        assert(smallMoved.hasOption("-q") && !smallMoved.hasOption("-v"));
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on the snapshots of the parsed values
+    {
+        std::cout << "Testing cliparser::ParseResult::snapshot...\n";
+        int boundJobs = 1;
+        auto declare = [&boundJobs](cliparser::CliParser& p) {
+            p.option<int>("-n", "n").option("-l", "long", 2L).option("-x", "long double", 1.5L).option("-s", "string", std::string("default"))
+                .option("-v", "view", std::string_view("view")).option("-i", "ids", std::vector<int>{1}).option("-d", "doubles", std::vector<double>())
+                .option("--cache", "cache", Bytes{1}).option("--color", "color", Color::RED).flag("-q", "quiet").flag("-z", "unused").bind("-j", boundJobs, "jobs").env("-l", "SNAPSHOT_TEST_L");
+        };
+        cliparser::CliParser launcher("launcher", "snapshot test");
+        declare(launcher);
+        char snapEnv[] = "SNAPSHOT_TEST_L=77";
+        char* snapEnvp[] = {snapEnv, nullptr};
+        launcher.environment(snapEnvp);
+        const char* snapArgs[] = {"launcher", "-n", "5", "-x=2.25", "-s", "a string longer than the small string optimisation", "-v=abc", "-i", "3,4,5", "-d=0.5", "--cache=2KiB", "--color=blue", "-q", "-j", "8"};
+        launcher.parse(15, const_cast<char**>(snapArgs));
+
+        std::vector<std::byte> snap = launcher.snapshot();
+        cliparser::ParseResult launcherResult(launcher);
+        launcher.parse(15, const_cast<char**>(snapArgs), launcherResult);
+        std::vector<std::byte> tooSmall(snap.size() - 1);
+        assert(launcherResult.snapshot() == snap && launcherResult.snapshot(tooSmall) == snap.size());  // the bound option is in the result too
+
+        boundJobs = 1;
+        std::vector<std::byte> decoded;
+        assert(cliparser::fromBase64(cliparser::toBase64(snap), decoded) && decoded == snap);
+        decoded.resize(decoded.size() + 7);  // the bytes after the snapshot are ignored, e.g. the padding of a mapping
+        cliparser::CliParser worker("worker", "snapshot test");
+        declare(worker);
+        assert(worker.schemaHash() == launcher.schemaHash() && !worker.restore(decoded));
+        assert(worker.getOption<int>("-n") == 5 && worker.getOption<long>("-l") == 77 && worker.getOption<long double>("-x") == 2.25L);
+        assert(worker.getOption<std::string>("-s") == "a string longer than the small string optimisation" && worker.getOption<std::string_view>("-v") == "abc");
+        assert((worker.getOption<std::vector<int>>("-i") == std::vector<int>{3, 4, 5}) && (worker.getOption<std::vector<double>>("-d") == std::vector<double>{0.5}));
+        assert(worker.getOption<Bytes>("--cache").count == 2048 && worker.getOption<Color>("--color") == Color::BLUE && boundJobs == 8);
+        assert(worker.getOption<bool>("-q") && !worker.getOption<bool>("-z") && worker.isOptionSetByUser("-q") && !worker.isOptionSetByUser("-z"));
+        assert(worker.source("-l") == cliparser::OptionSource::ENVIRONMENT && worker.source("-n") == cliparser::OptionSource::COMMAND_LINE);
+
+        cliparser::ParseResult workerResult(worker);
+        assert(!workerResult.restore(snap) && workerResult.getOption<int>("-j") == 8 && workerResult.getOption<int>("-n") == 5);
+
+        // lazy conversion: the pending tokens are converted before the snapshot
+        cliparser::CliParser lazySnap("lazy", "snapshot test");
+        lazySnap.option("-n", "n", 1).enableLazyConversion();
+        char* lazyArgs[] = {const_cast<char*>("lazy"), const_cast<char*>("-n=12")};
+        lazySnap.parse(2, lazyArgs);
+        cliparser::ParseResult lazyRestored(lazySnap);
+        assert(!lazyRestored.restore(lazySnap.snapshot()) && lazyRestored.getOption<int>("-n") == 12);
+
+        // the snapshots of another schema and the damaged ones are rejected, and the result is left reset
+        cliparser::CliParser other("other", "snapshot test");
+        declare(other);
+        other.option("--extra", "one more option", 0);
+        assert(other.schemaHash() != launcher.schemaHash() && other.restore(snap).code == cliparser::ParseErrc::SNAPSHOT_SCHEMA_MISMATCH);
+
+        // two schemas that differ only in a user-defined type
+        cliparser::CliParser bytesCache("bytes", "snapshot test"), colorCache("color", "snapshot test");
+        bytesCache.option("--cache", "cache", Bytes{1});
+        colorCache.option("--cache", "cache", Color::RED);
+        char* noArgs[] = {const_cast<char*>("bytes")};
+        bytesCache.parse(1, noArgs);
+        std::vector<std::byte> bytesSnap = bytesCache.snapshot();
+        assert(bytesCache.schemaHash() != colorCache.schemaHash() && colorCache.restore(bytesSnap).code == cliparser::ParseErrc::SNAPSHOT_SCHEMA_MISMATCH);
+        cliparser::CliParser movedCache(std::move(colorCache));
+        colorCache.option("--cache", "cache", Bytes{2});  // the moved-from parser starts again from the hash of an empty schema
+        assert(colorCache.schemaHash() == bytesCache.schemaHash() && !colorCache.restore(bytesSnap) && movedCache.schemaHash() != bytesCache.schemaHash());
+        assert(worker.restore(std::span<const std::byte>(snap).first(snap.size() - 1)).code == cliparser::ParseErrc::BAD_SNAPSHOT && !worker.isOptionSetByUser("-n"));
+        std::vector<std::byte> damaged = snap;
+        damaged[0] ^= std::byte{1};
+        assert(worker.restore(damaged).code == cliparser::ParseErrc::BAD_SNAPSHOT && !worker.restore(std::span<const std::byte>()).message().empty());
+        assert(worker.restore(std::span<const std::byte>()).code == cliparser::ParseErrc::BAD_SNAPSHOT);
+        assert(!cliparser::fromBase64("abc", decoded) && !cliparser::fromBase64("a=bc", decoded) && cliparser::fromBase64("", decoded) && decoded.empty());
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on the positional arguments
+    {
+        std::cout << "Testing cliparser::CliParser::enablePositionals...\n";
+        cliparser::CliParser files("files", "positional arguments test");
+        files.option("-n", "n", 1).flag("-v", "verbose");
+        char* posArgs[] = {const_cast<char*>("files"), const_cast<char*>("a.txt"), const_cast<char*>("-v"), const_cast<char*>("-"), const_cast<char*>("k=v"), 
+            const_cast<char*>("-n"), const_cast<char*>("2"), const_cast<char*>("--"), const_cast<char*>("-n"), const_cast<char*>("@not-a-file"), const_cast<char*>("--")};
+        assert(files.tryParse(11, posArgs).code == cliparser::ParseErrc::NO_SUCH_OPTION);  // disabled by default
+        assert(files.help().find("args...") == std::string::npos);
+        files.enablePositionals();
+        assert(files.help().find("[--] [args...]") != std::string::npos);
+        files.parse(11, posArgs);
+        std::span<const std::string_view> collected = files.positionals();
+        assert(collected.size() == 6 && collected[0] == "a.txt" && collected[1] == "-" && collected[2] == "k=v" && collected[3] == "-n" && collected[4] == "@not-a-file" && collected[5] == "--");
+        assert(collected[0].data() == posArgs[1]);  // no copy: the views point into argv
+        assert(files.remainder().size() == 3 && files.remainder()[0] == "-n" && files.getOption<int>("-n") == 2 && files.getOption<bool>("-v"));
+
+        char* unknownDash[] = {const_cast<char*>("files"), const_cast<char*>("b.txt"), const_cast<char*>("-x")};
+        cliparser::ParseError posErr = files.tryParse(3, unknownDash);
+        assert(posErr.code == cliparser::ParseErrc::NO_SUCH_OPTION && posErr.index == 2);
+        assert(!files.tryParse(3, unknownDash, true) && files.positionals().size() == 1 && files.remainder().empty());  // every parse starts over
+        files.reset();
+        assert(files.positionals().empty());
+
+        // many positional arguments, from argv and from a response file, into a ParseResult
+        std::string listPath = (std::filesystem::temp_directory_path() / "cliparser_test_files.rsp").string();
+        {
+            std::ofstream list(listPath);
+            for (int k = 0; k < 100000; ++k) list << "dir/file" << k << ".dat\n";
+        }
+        std::vector<std::string> manyTokens;
+        for (int k = 0; k < 100000; ++k) manyTokens.push_back("path" + std::to_string(k));
+        manyTokens.push_back("@" + listPath);
+        std::vector<char*> manyArgv = {const_cast<char*>("files")};
+        for (std::string& t : manyTokens) manyArgv.push_back(t.data());
+        files.enableResponseFiles();
+        cliparser::ParseResult manyResult(files);
+        assert(!files.tryParse(static_cast<int>(manyArgv.size()), manyArgv.data(), manyResult));
+        assert(manyResult.positionals().size() == 200000 && manyResult.positionals()[99999] == "path99999" && manyResult.positionals()[199999] == "dir/file99999.dat");
+        files.enableResponseFiles(false);
+        manyResult.reset();
+        std::filesystem::remove(listPath);
+
+        // the CliParser of a subcommand inherits the setting
+        cliparser::CliParser tool("tool", "positional arguments test");
+        tool.enablePositionals().subcommand("add", "add files", [](cliparser::CliParser& sub) {sub.flag("-f", "force");});
+        char* toolArgs[] = {const_cast<char*>("tool"), const_cast<char*>("first"), const_cast<char*>("add"), const_cast<char*>("-f"), const_cast<char*>("x.c"), const_cast<char*>("y.c")};
+        tool.parse(6, toolArgs);
+        assert(tool.positionals().size() == 1 && tool.selectedSubcommand() == "add" && tool.subcommandParser("add")->positionals().size() == 2 && tool.subcommandParser("add")->positionals()[1] == "y.c");
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on the required options check, across several 64-bit words of option state
+    {
+        std::cout << "Testing the required options check...\n";
+        cliparser::CliParser r("required", "required options test");
+        std::vector<std::string> reqNames, reqArgs;
+        for (int k = 0; k < 130; ++k) {
+            reqNames.push_back("-o" + std::to_string(k));
+            if (k % 2 == 0) r.option<int>(reqNames.back(), "required");
+            else r.option(reqNames.back(), "optional", k);
+        }
+        cliparser::OptionHandle<bool> reqFlag;
+        r.flag("--f", "flag", reqFlag);
+        assert(r.isOptionFlag("--f") && r.isOptionOptional("--f") && !r.isOptionOptional("-o64") && r.isOptionOptional("-o65"));
+
+        std::vector<char*> reqArgv = {const_cast<char*>("required")};
+        for (int k = 0; k < 130; k += 2) {
+            if (k == 70 || k == 128) continue;  // missing
+            reqArgv.push_back(reqNames[k].data());
+            reqArgv.push_back(const_cast<char*>("1"));
+        }
+        cliparser::ParseError reqErr = r.tryParse(static_cast<int>(reqArgv.size()), reqArgv.data());
+        assert(reqErr.code == cliparser::ParseErrc::MISSING_REQUIRED_OPTION && reqErr.option == "-o70");  // the first missing option, in declaration order
+        assert(r.isOptionSetByUser("-o64") && !r.isOptionSetByUser("-o65"));
+
+        bool hasExceptionHappened = false;
+        try {
+            r.parse(static_cast<int>(reqArgv.size()), reqArgv.data());
+        }
+        catch (const cliparser::MissingRequiredOptionsError& e) {
+            std::string what = e.what();
+            hasExceptionHappened = what.find("-o70 ") != std::string::npos && what.find("-o128 ") != std::string::npos && what.find("-o0 ") == std::string::npos;
+        }
+        assert(hasExceptionHappened);
+        std::string o70 = "-o70=1", o128 = "-o128=1";
+        reqArgv.push_back(o70.data());
+        reqArgv.push_back(o128.data());
+        assert(!r.tryParse(static_cast<int>(reqArgv.size()), reqArgv.data()));
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on cliparser::CliParser::complete and the abbreviations
+    {
+        std::cout << "Testing cliparser::CliParser::complete...\n";
+        cliparser::CliParser c("complete", "completion test");
+        c.flag("--verbose", "v").flag("--version", "V").option("--ver", "exact", 1).option("--output", "o", std::string("a.out")).flag("-x", "x");
+        std::span<const std::string_view> matches = c.complete("--ver");
+        assert(matches.size() == 3 && matches[0] == "--ver" && matches[1] == "--verbose" && matches[2] == "--version");
+        assert(c.complete("--o").size() == 1 && c.complete("--z").empty() && c.complete("").size() == 5);
+        assert(c.optionNames().size() == 5 && c.optionNames()[0] == "--verbose");  // declaration order
+
+        char* abbrev[] = {const_cast<char*>("complete"), const_cast<char*>("--verb"), const_cast<char*>("--out=b.out")};
+        assert(c.tryParse(3, abbrev).code == cliparser::ParseErrc::NO_SUCH_OPTION);  // disabled by default
+        c.enableAbbreviations();
+        assert(!c.tryParse(3, abbrev) && c.getOption<bool>("--verbose") && c.getOption<std::string>("--output") == "b.out");
+        char* ambiguous[] = {const_cast<char*>("complete"), const_cast<char*>("--ve")};
+        cliparser::ParseError abbrevErr = c.tryParse(2, ambiguous);
+        assert(abbrevErr.code == cliparser::ParseErrc::AMBIGUOUS_OPTION && abbrevErr.option == "--ve");
+        char* exact[] = {const_cast<char*>("complete"), const_cast<char*>("--ver=5"), const_cast<char*>("--verbose=1")};
+        abbrevErr = c.tryParse(3, exact);  // --ver is an exact match
+        assert(abbrevErr.code == cliparser::ParseErrc::FLAG_WITH_VALUE && abbrevErr.index == 2 && c.getOption<int>("--ver") == 5);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on cliparser::CliParser::env
+    {
+        std::cout << "Testing cliparser::CliParser::env...\n";
+        cliparser::CliParser e("env", "environment test");
+        e.option<int>("-n", "required").option("-j", "jobs", 4).option("-o", "output", std::string("a.out")).flag("-v", "verbose");
+        e.env("-n", "APP_N").env("-j", "APP_JOBS").env("-v", "APP_VERBOSE");
+        char* block[] = {const_cast<char*>("PATH=/bin"), const_cast<char*>("APP_N=7"), const_cast<char*>("APP_JOBS=16"), const_cast<char*>("APP_VERBOSE=true"), const_cast<char*>("APP_JOBS_X=1"), nullptr};
+        e.environment(block);
+
+        char* envArgv[] = {const_cast<char*>("env"), const_cast<char*>("-j"), const_cast<char*>("2")};
+        assert(!e.tryParse(3, envArgv));  // -n is required, and provided by APP_N
+        assert(e.getOption<int>("-n") == 7 && e.getOption<int>("-j") == 2 && e.getOption<bool>("-v"));
+        assert(e.source("-n") == cliparser::OptionSource::ENVIRONMENT && e.source("-j") == cliparser::OptionSource::COMMAND_LINE && e.source("-o") == cliparser::OptionSource::DEFAULT);
+
+        char* badBlock[] = {const_cast<char*>("APP_JOBS=many"), nullptr};
+        e.environment(badBlock);
+        e.reset();
+        cliparser::ParseError envErr = e.tryParse(1, envArgv);
+        assert(envErr.code == cliparser::ParseErrc::INVALID_VALUE && envErr.index == -1 && envErr.option == "-j" && envErr.value == "many");
+
+        // with lazy conversion, a flag on the command line overrides the raw value of its environment variable
+        cliparser::CliParser lazyEnv("env", "lazy environment test");
+        lazyEnv.flag("--verbose", "verbose").env("--verbose", "APP_VERBOSE").enableLazyConversion();
+        char* falseBlock[] = {const_cast<char*>("APP_VERBOSE=false"), nullptr};
+        lazyEnv.environment(falseBlock);
+        char* verboseArgv[] = {const_cast<char*>("env"), const_cast<char*>("--verbose")};
+        lazyEnv.parse(2, verboseArgv);
+        assert(lazyEnv.getOption<bool>("--verbose") && lazyEnv.source("--verbose") == cliparser::OptionSource::COMMAND_LINE);
+        std::cout << "Test passed.\n";
+
+        // a test on cliparser::CliParser::configFile
+        std::cout << "Testing cliparser::CliParser::configFile...\n";
+        std::string config = (std::filesystem::temp_directory_path() / "cliparser_test.conf").string();
+        std::ofstream(config) << "# comment\n; comment\n\n  j = 8  \n o = \"my file.txt\"\nv=false\n[net]\nport=8080\r\n";
+        e.option("--net.port", "port", 80).option("--timeout", "timeout", 1.5);
+        e.configFile(config).configFile("/cliparser/no/such/file.conf", false);
+        e.environment(block);  // APP_N=7, APP_JOBS=16, APP_VERBOSE=true
+        e.reset();
+        char* timeout[] = {const_cast<char*>("env"), const_cast<char*>("--timeout=3")};
+        assert(!e.tryParse(2, timeout));
+        assert(e.getOption<std::string>("-o") == "my file.txt" && e.getOption<int>("--net.port") == 8080);
+        assert(e.source("-o") == cliparser::OptionSource::CONFIG_FILE && e.source("--net.port") == cliparser::OptionSource::CONFIG_FILE);
+        assert(e.getOption<int>("-j") == 16 && e.source("-j") == cliparser::OptionSource::ENVIRONMENT);  // file < env
+        assert(e.getOption<bool>("-v") && e.getOption<double>("--timeout") == 3 && e.source("--timeout") == cliparser::OptionSource::COMMAND_LINE);
+
+        // with lazy conversion, a flag on the command line overrides the raw value of the configuration file (v=false)
+        e.environment(badBlock).enableLazyConversion();  // APP_JOBS=many is overridden by -j
+        e.reset();
+        char* lazyFlag[] = {const_cast<char*>("env"), const_cast<char*>("-v"), const_cast<char*>("-n"), const_cast<char*>("1"), const_cast<char*>("-j"), const_cast<char*>("3")};
+        assert(!e.tryParse(6, lazyFlag));
+        assert(e.getOption<bool>("-v") && e.source("-v") == cliparser::OptionSource::COMMAND_LINE && e.getOption<int>("-j") == 3);
+        e.enableLazyConversion(false).environment(block);
+
+        std::ofstream(config) << "j = 1\nnot a key value pair\n";
+        e.reset();
+        envErr = e.tryParse(2, timeout);
+        assert(envErr.code == cliparser::ParseErrc::BAD_CONFIG_FILE && envErr.index == 2);
+        std::ofstream(config) << "unknown = 1\n";
+        e.reset();
+        envErr = e.tryParse(2, timeout);
+        assert(envErr.code == cliparser::ParseErrc::NO_SUCH_OPTION && envErr.index == 1 && envErr.option == "unknown");
+        assert(!e.tryParse(2, timeout, true));  // ignoreUnknownOptions
+        std::filesystem::remove(config);
+        e.reset();
+        assert(e.tryParse(2, timeout).code == cliparser::ParseErrc::BAD_CONFIG_FILE);  // required file
+
+        // a list set by two files: the later file replaces the values of the earlier one, a repeated key appends within a file
+        std::string systemConfig = (std::filesystem::temp_directory_path() / "cliparser_test_system.conf").string();
+        std::string userConfig = (std::filesystem::temp_directory_path() / "cliparser_test_user.conf").string();
+        std::ofstream(systemConfig) << "ids = 1,2\nids = 3\nlevels = 4\n";
+        std::ofstream(userConfig) << "ids = 7\nids = 8\n";
+        cliparser::CliParser layered("layered", "configuration files test");
+        layered.option("--ids", "ids", std::vector<int>{}).option("--levels", "levels", std::vector<int>{}).configFile(systemConfig).configFile(userConfig);
+        char* layeredLine[] = {const_cast<char*>("layered")};
+        assert(!layered.tryParse(1, layeredLine));
+        assert((layered.getOption<std::vector<int>>("--ids") == std::vector<int>{7, 8}) && (layered.getOption<std::vector<int>>("--levels") == std::vector<int>{4}));
+        assert(layered.source("--ids") == cliparser::OptionSource::CONFIG_FILE);
+        std::filesystem::remove(userConfig);
+        std::ofstream(userConfig) << "levels = 5\n";
+        layered.reset();
+        assert(!layered.tryParse(1, layeredLine));
+        assert((layered.getOption<std::vector<int>>("--ids") == std::vector<int>{1, 2, 3}) && (layered.getOption<std::vector<int>>("--levels") == std::vector<int>{5}));
+        std::filesystem::remove(systemConfig);
+        std::filesystem::remove(userConfig);
+
+        // an optional file whose existence cannot be checked (the name is too long) is an error, not an exception
+        cliparser::CliParser unreadable("unreadable", "configuration file test");
+        std::string longName = (std::filesystem::temp_directory_path() / std::string(300, 'c')).string();
+        unreadable.option("-j", "jobs", 1).configFile(longName, false);
+        char* noArgs[] = {const_cast<char*>("unreadable")};
+        envErr = unreadable.tryParse(1, noArgs);
+        assert(envErr.code == cliparser::ParseErrc::BAD_CONFIG_FILE && envErr.option == longName);
+        std::cout << "Test passed.\n";
+    }
+
+    // a test on cliparser::CliParser::help
+    {
+        std::cout << "Testing cliparser::CliParser::help...\n";
+        cliparser::CliParser h("app", "help test", "1.0");
+        h.helpWidth(40).option<int>("--zeta", "declared first").option("-a", "optional, with a description long enough to be wrapped", 1).flag("--a-really-long-flag-name-for-help", "flag");
+        std::string full = h.help(true, false, true);
+        assert(full.starts_with("app --zeta [-a]\n    [--a-really-long-flag-name-for-help]\n"));  // declaration order, wrapped usage
+        assert(full.find("\nversion: 1.0\n") != std::string::npos);
+        assert(full.find("  --zeta  declared first\n") != std::string::npos);
+        assert(full.find("  -a      optional, with a description\n          long enough to be wrapped\n") != std::string::npos);
+        assert(full.find("  --a-really-long-flag-name-for-help\n          flag\n") != std::string::npos);
+
+        std::ostringstream os;
+        h.help(os, true, false, true);
+        assert(os.str() == full && h.help(true, false, true) == full);  // cached
+        std::vector<char> buffer(h.help(std::span<char>(), true, false, true));
+        assert(buffer.size() == full.size() && h.help(buffer, true, false, true) == full.size() && std::string(buffer.begin(), buffer.end()) == full);
+
+        h.option<std::string>("-b", "added later");
+        assert(h.help().starts_with("app --zeta [-a]\n    [--a-really-long-flag-name-for-help]\n    -b\n"));  // the cache is rebuilt
+        std::cout << "Test passed.\n";
+    }
+
+    #ifdef LIBCLIPARSER_STATS
+    // a test on the parse statistics
+    {
+        std::cout << "Testing cliparser::ParseStats...\n";
+        cliparser::CliParser st("stats", "statistics test");
+        st.option<int>("-n", "integer").option("-s", "string", std::string()).option("-x", "double", 1.0).flag("-v", "flag");
+        std::size_t hookCalls = 0;
+        st.onParseStats([&hookCalls](const cliparser::ParseStats& stats) {hookCalls += stats.tokens > 0;});
+
+        char* statsLine[] = {const_cast<char*>("stats"), const_cast<char*>("-n"), const_cast<char*>("3"), const_cast<char*>("-s=a string longer than the small buffer"), const_cast<char*>("-v")};
+        cliparser::ParseResult statsResult(st);
+        assert(!st.tryParse(5, statsLine, statsResult));
+        const cliparser::ParseStats& stats = statsResult.stats();
+        assert(stats.tokens == 4 && stats.lookups == 3 && stats.conversionsOf<int>() == 1 && stats.conversionsOf<std::string>() == 1 && stats.conversionsOf<double>() == 0);
+        assert(stats.allocations == 1 && stats.exceptions == 0 && stats.schemaBuild.count() > 0 && hookCalls == 1);
+
+        bool hasExceptionHappened = false;
+        statsResult.reset();
+        try {st.parse(1, statsLine, statsResult);}
+        catch (const cliparser::MissingRequiredOptionsError& e) {hasExceptionHappened = true;}
+        assert(hasExceptionHappened && statsResult.stats().exceptions == 1 && statsResult.stats().tokens == 0 && hookCalls == 1);
+        std::cout << "Test passed.\n";
+    }
+    #endif
+
+    // a test on cliparser::Schema
+    {
+        std::cout << "Testing cliparser::Schema...\n";
+        using TestSchema = cliparser::Schema<
+            cliparser::Opt<"-n", int, "integer">,
+            cliparser::OptDefault<"-q", 3.22f, "optional float">,
+            cliparser::OptDefault<"--usr", cliparser::FixedString("guest"), "user">,
+            cliparser::Flag<"--help", "print help">
+        >;
+        static_assert(TestSchema::find("-n") == 0 && TestSchema::find("--help") == 3);
+        static_assert(!TestSchema::hasOption("-x"));
+
+        TestSchema::Result res;
+        assert(res.get<"-q">() == 3.22f && res.get<"--usr">() == "guest" && !res.get<"--help">());
+
+        char* args[] = {const_cast<char*>("test"), const_cast<char*>("-n"), const_cast<char*>("42"), const_cast<char*>("--usr=admin"), const_cast<char*>("--help")};
+        TestSchema::parse(5, args, res);
+        assert(res.get<"-n">() == 42 && res.get<"--usr">() == "admin" && res.get<"--help">());
+        assert(res.isSetByUser<"-n">() && !res.isSetByUser<"-q">());
+
+        bool hasExceptionHappened = false;
+        try {
+            TestSchema::Result missing;
+            TestSchema::parse(1, args, missing);
+        }
+        catch (const cliparser::MissingRequiredOptionsError& e) {
+            std::cerr << e.what() << std::endl;
+            hasExceptionHappened = true;
+        }
+        assert(hasExceptionHappened);
+        std::cout << "Test passed.\n";
+    }
+
     std::cout << "\n\nReached the end of the test section\n\n";
     #endif
 